@@ -0,0 +1,184 @@
+#include "artic.h"
+#include <string.h>
+
+static uint32_t artic_neighbours(struct Artic* ar, uint32_t ci, uint32_t* out)
+{
+    /* Get indices of neighbours within grid, N E S W order */
+    uint32_t x = ci % ar->xsize;
+    uint32_t y = ci / ar->xsize;
+    uint32_t n = 0;
+
+    if (y > 0)
+        out[n++] = ci - ar->xsize;
+    if (x < ar->xsize-1)
+        out[n++] = ci + 1;
+    if (y < ar->ysize-1)
+        out[n++] = ci + ar->xsize;
+    if (x > 0)
+        out[n++] = ci - 1;
+    return n;
+}
+
+void artic_init(struct Artic* ar, uint32_t xsize, uint32_t ysize)
+{
+    uint32_t size = xsize*ysize;
+
+    ar->xsize = xsize;
+    ar->ysize = ysize;
+    ar->wall = malloc(size * sizeof(uint8_t));
+    ar->disc = malloc(size * sizeof(uint32_t));
+    ar->low = malloc(size * sizeof(uint32_t));
+    ar->parent = malloc(size * sizeof(uint32_t));
+    ar->sub = malloc(size * sizeof(uint32_t));
+    ar->root = malloc(size * sizeof(uint32_t));
+    ar->is_cut = malloc(size * sizeof(uint8_t));
+    ar->stack = malloc(size * sizeof(uint32_t));
+    ar->it = malloc(size * sizeof(uint8_t));
+}
+
+void artic_destroy(struct Artic* ar)
+{
+    free(ar->wall);
+    free(ar->disc);
+    free(ar->low);
+    free(ar->parent);
+    free(ar->sub);
+    free(ar->root);
+    free(ar->is_cut);
+    free(ar->stack);
+    free(ar->it);
+}
+
+static void artic_dfs(struct Artic* ar, uint32_t r, uint32_t* time)
+{
+    /* Iterative Tarjan DFS from root r */
+    uint32_t nb[4];
+    uint32_t sp = 0;
+    uint32_t nchildren = 0;
+
+    ar->disc[r] = ar->low[r] = ++(*time);
+    ar->parent[r] = ARTIC_NONE;
+    ar->sub[r] = 1;
+    ar->root[r] = r;
+    ar->it[r] = 0;
+    ar->stack[sp++] = r;
+
+    while (sp > 0) {
+        uint32_t u = ar->stack[sp-1];
+        uint32_t n = artic_neighbours(ar, u, nb);
+
+        if (ar->it[u] < n) {
+            uint32_t v = nb[ar->it[u]++];
+
+            if (ar->wall[v])
+                continue;
+
+            if (ar->disc[v] == 0) {
+                ar->disc[v] = ar->low[v] = ++(*time);
+                ar->parent[v] = u;
+                ar->sub[v] = 1;
+                ar->root[v] = r;
+                ar->it[v] = 0;
+                ar->stack[sp++] = v;
+                if (u == r)
+                    nchildren++;
+            }
+            else if (v != ar->parent[u] && ar->disc[v] < ar->low[u]) {
+                ar->low[u] = ar->disc[v];
+            }
+            continue;
+        }
+
+        // u is done, hand results to parent
+        sp--;
+        uint32_t p = ar->parent[u];
+        if (p == ARTIC_NONE)
+            continue;
+
+        ar->sub[p] += ar->sub[u];
+        if (ar->low[u] < ar->low[p])
+            ar->low[p] = ar->low[u];
+        if (p != r && ar->low[u] >= ar->disc[p])
+            ar->is_cut[p] = 1;
+    }
+
+    ar->is_cut[r] = nchildren > 1;
+}
+
+void artic_update(struct Artic* ar, struct Game* game)
+{
+    /* Find cut cells for current game state */
+    struct Snake* snake = &game->snake;
+    uint32_t size = ar->xsize*ar->ysize;
+    uint32_t time = 0;
+
+    memset(ar->wall, 0, size);
+    memset(ar->disc, 0, size * sizeof(uint32_t));
+    memset(ar->is_cut, 0, size);
+
+    // NOTE shead/stail refers to the head/tail of linked list, not snake's head/tail
+    struct Seg* seg = (snake->cur_len < snake->len) ? *snake->shead : (*snake->shead)->next;
+    for ( ; seg != NULL ; seg = seg->next)
+        ar->wall[seg->ypos*ar->xsize + seg->xpos] = 1;
+
+    for (uint32_t i=0 ; i<size ; i++) {
+        if (!ar->wall[i] && ar->disc[i] == 0)
+            artic_dfs(ar, i, &time);
+    }
+}
+
+static bool artic_is_split(struct Artic* ar, uint32_t c, uint32_t v)
+{
+    // subtree of child v is cut off from the rest when c becomes wall
+    return ar->low[v] >= ar->disc[c];
+}
+
+static uint32_t artic_rest(struct Artic* ar, uint32_t c)
+{
+    /* Size of the region on the parent side of c after c becomes wall */
+    uint32_t nb[4];
+    uint32_t rest = ar->sub[ar->root[c]] - 1;
+
+    for (uint32_t i=0, n=artic_neighbours(ar, c, nb) ; i<n ; i++) {
+        uint32_t v = nb[i];
+        if (!ar->wall[v] && ar->parent[v] == c && artic_is_split(ar, c, v))
+            rest -= ar->sub[v];
+    }
+    return rest;
+}
+
+uint32_t artic_space(struct Artic* ar, uint32_t c, uint32_t w)
+{
+    uint32_t nb[4];
+
+    if (!ar->is_cut[c])
+        return ar->sub[ar->root[c]] - 1;
+
+    // descendants of c are in the subtree of one of its children
+    if (ar->disc[w] > ar->disc[c]) {
+        for (uint32_t i=0, n=artic_neighbours(ar, c, nb) ; i<n ; i++) {
+            uint32_t v = nb[i];
+            if (ar->wall[v] || ar->parent[v] != c)
+                continue;
+            if (ar->disc[w] >= ar->disc[v] && ar->disc[w] < ar->disc[v] + ar->sub[v])
+                return artic_is_split(ar, c, v) ? ar->sub[v] : artic_rest(ar, c);
+        }
+    }
+    return artic_rest(ar, c);
+}
+
+uint32_t artic_best_space(struct Artic* ar, uint32_t c)
+{
+    uint32_t nb[4];
+
+    if (!ar->is_cut[c])
+        return ar->sub[ar->root[c]] - 1;
+
+    uint32_t best = artic_rest(ar, c);
+    for (uint32_t i=0, n=artic_neighbours(ar, c, nb) ; i<n ; i++) {
+        uint32_t v = nb[i];
+        if (!ar->wall[v] && ar->parent[v] == c && artic_is_split(ar, c, v) && ar->sub[v] > best)
+            best = ar->sub[v];
+    }
+    return best;
+}
@@ -0,0 +1,56 @@
+#ifndef ARTIC_H
+#define ARTIC_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "astar.h"
+#include "snake.h"
+
+/* Articulation points (cut cells) of the free cell graph
+ *
+ * One iterative Tarjan DFS over all free cells per tick finds the cells
+ * that split free space when the head moves into them. Because discovery
+ * times are assigned in pre-order, the DFS subtree of a cell is a range of
+ * discovery times, so the region a neighbour ends up in after the split is
+ * found without a flood fill.
+ *
+ * Free cells are the same as for the shortest path planner: everything but
+ * the body, tail included unless the snake is growing. Edges don't wrap.
+ */
+
+#define ARTIC_NONE UINT32_MAX
+
+struct Artic {
+    uint32_t xsize;
+    uint32_t ysize;
+
+    uint8_t* wall;
+
+    // DFS pre-order discovery time, 0 is unvisited
+    uint32_t* disc;
+    uint32_t* low;
+    uint32_t* parent;
+
+    // size of DFS subtree, and DFS root of component
+    uint32_t* sub;
+    uint32_t* root;
+    uint8_t* is_cut;
+
+    // iterative DFS stack and next neighbour to visit per cell
+    uint32_t* stack;
+    uint8_t* it;
+};
+
+void artic_init(struct Artic* ar, uint32_t xsize, uint32_t ysize);
+void artic_destroy(struct Artic* ar);
+void artic_update(struct Artic* ar, struct Game* game);
+
+// free cells reachable from w after c becomes wall, c and w are adjacent free cells
+uint32_t artic_space(struct Artic* ar, uint32_t c, uint32_t w);
+
+// largest region left after c becomes wall
+uint32_t artic_best_space(struct Artic* ar, uint32_t c);
+
+#endif
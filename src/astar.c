@@ -1,4 +1,5 @@
 #include "astar.h"
+#include "prof.h"
 
 void set_debug(struct Set* set, char* prefix)
 {
@@ -26,15 +27,17 @@ void i2pos(uint32_t i, Pos* x, Pos* y, uint32_t xsize)
     *y = i / xsize;
 }
 
-bool is_in_grid(Pos x, Pos y, uint16_t xsize, uint16_t ysize)
+bool is_in_grid(Pos x, Pos y, uint32_t xsize, uint32_t ysize)
 {
     /* Check if coordinates are within grid dimensions */
-    return (x >= 0 && y >= 0 && x < xsize && y < ysize);
+    // Pos is unsigned, so x-1 at the edge wraps and is caught by upper bound
+    return (x < xsize && y < ysize);
 }
 
-struct Node* get_node(struct Node* grid, Pos x, Pos y, uint16_t xsize)
+struct Node* get_node(struct Node* grid, Pos x, Pos y, uint32_t xsize)
 {
-    return &grid[pos2i(x, y, xsize)];
+    /* Get board node, skipping the wall border */
+    return &grid[grid_i(x+1, y+1, xsize)];
 }
 
 void path_trace_back(struct Astar* astar, struct Node* n_end)
@@ -47,6 +50,57 @@ void path_trace_back(struct Astar* astar, struct Node* n_end)
     }
 }
 
+void astar_path_init(struct ASPath* path, uint8_t* buf, uint32_t size)
+{
+    /* Init path using a buffer of AS_PATH_BUFSIZE(size) bytes */
+    path->len = 0;
+    path->size = size;
+    path->steps = buf;
+}
+
+void astar_path_set(struct ASPath* path, uint32_t i, enum ASDir dir)
+{
+    uint8_t shift = (i % 4) * 2;
+    uint8_t* b = &path->steps[i / 4];
+    *b = (*b & ~(0x3 << shift)) | (dir << shift);
+}
+
+enum ASDir astar_path_get(struct ASPath* path, uint32_t i)
+{
+    return (path->steps[i / 4] >> ((i % 4) * 2)) & 0x3;
+}
+
+static enum ASDir node_dir(struct Node* from, struct Node* to)
+{
+    /* Direction of a step between two neighbouring nodes */
+    if (to->y < from->y)
+        return AS_DIR_N;
+    else if (to->x > from->x)
+        return AS_DIR_E;
+    else if (to->y > from->y)
+        return AS_DIR_S;
+    else
+        return AS_DIR_W;
+}
+
+enum ASResult astar_get_path(struct Astar* astar, struct ASPath* path)
+{
+    /* Materialize solved path by following parents back from end node once.
+     * Directions are stored in reverse so path can be read front to back */
+    struct Node* n = get_node(astar->grid, astar->x1, astar->y1, astar->xsize);
+
+    if (n->g > path->size)
+        return AS_ERROR;
+
+    path->len = n->g;
+
+    for (uint32_t i=path->len ; i>0 ; i--) {
+        astar_path_set(path, i-1, node_dir(n->parent, n));
+        n = n->parent;
+    }
+    return AS_SOLVED;
+}
+
 void astar_set_points(struct Astar* astar, Pos x0, Pos y0, Pos x1, Pos y1)
 {
     /* Set start and end points for algorithm */
@@ -60,14 +114,19 @@ void astar_set_points(struct Astar* astar, Pos x0, Pos y0, Pos x1, Pos y1)
     // Init all points with the propper heuristic (physical distance from end point
     // G cannot be set since it is the path distance to start point
     // F cannot be set since it is calculated from G: F=G+H)
-    struct Node* n = astar->grid;
-    for (int i=0 ; i<astar->xsize*astar->ysize ; i++, n++) {
+    for (uint32_t i=0 ; i<AS_XSIZE(astar)*AS_YSIZE(astar) ; i++) {
+        Pos x, y;
+        i2pos(i, &x, &y, AS_XSIZE(astar));
+
+        struct Node* n = get_node(astar->grid, x, y, AS_XSIZE(astar));
         n->f = 0;
         n->g = 0;
 
-        i2pos(i, &n->x, &n->y, astar->xsize);
+        n->x = x;
+        n->y = y;
         n->is_wall = false;
-        n->h = abs(x1 - n->x) + abs(y1 - n->y);
+        n->is_goal = false;
+        n->h = ((x1 > n->x) ? x1 - n->x : n->x - x1) + ((y1 > n->y) ? y1 - n->y : n->y - y1);
         n->chksum = CHKSUM;
 
         /*
@@ -91,9 +150,85 @@ void astar_set_points(struct Astar* astar, Pos x0, Pos y0, Pos x1, Pos y1)
 
         n->parent = NULL;
     }
+
+    get_node(astar->grid, x1, y1, astar->xsize)->is_goal = true;
+}
+
+static void h_relax(struct Node* n, struct Node* n_from)
+{
+    // unreached nodes have max cost, don't let it wrap around
+    if (n_from->h != (Cost)~0 && n_from->h + 1 < n->h)
+        n->h = n_from->h + 1;
+}
+
+void astar_set_goals(struct Astar* astar, Pos x0, Pos y0, const Pos* goals, uint32_t ngoals)
+{
+    /* Set start point and ngoals end points as x,y pairs, search ends at
+     * the first goal that is reached.
+     * Heuristic is manhattan distance to the nearest goal. It is computed
+     * for all nodes with a two pass distance transform, so setup doesn't
+     * scale with the amount of goals */
+    astar->x0 = x0;
+    astar->y0 = y0;
+    astar->x1 = goals[0];
+    astar->y1 = goals[1];
+
+    struct Node* n;
+    for (uint32_t i=0 ; i<AS_XSIZE(astar)*AS_YSIZE(astar) ; i++) {
+        Pos x, y;
+        i2pos(i, &x, &y, AS_XSIZE(astar));
+
+        n = get_node(astar->grid, x, y, AS_XSIZE(astar));
+        n->f = 0;
+        n->g = 0;
+
+        n->x = x;
+        n->y = y;
+        n->is_wall = false;
+        n->is_goal = false;
+        n->h = (Cost)~0;
+        n->chksum = CHKSUM;
+        n->parent = NULL;
+    }
+
+    for (uint32_t i=0 ; i<ngoals ; i++) {
+        n = get_node(astar->grid, goals[i*2], goals[i*2+1], astar->xsize);
+        n->is_goal = true;
+        n->h = 0;
+    }
+
+    // forward pass takes distances from above and left,
+    // backward pass from below and right. Border nodes are unreached
+    // so they never relax a board node
+    for (uint32_t y=0 ; y<astar->ysize ; y++) {
+        for (uint32_t x=0 ; x<astar->xsize ; x++) {
+            n = get_node(astar->grid, x, y, astar->xsize);
+            h_relax(n, astar_neighbour(astar, n, AS_DIR_W));
+            h_relax(n, astar_neighbour(astar, n, AS_DIR_N));
+        }
+    }
+    for (uint32_t y=astar->ysize ; y-->0 ;) {
+        for (uint32_t x=astar->xsize ; x-->0 ;) {
+            n = get_node(astar->grid, x, y, astar->xsize);
+            h_relax(n, astar_neighbour(astar, n, AS_DIR_E));
+            h_relax(n, astar_neighbour(astar, n, AS_DIR_S));
+        }
+    }
+}
+
+static void astar_init_border(struct Node* n)
+{
+    // unreached so border doesn't affect heuristic passes
+    n->f = 0;
+    n->g = 0;
+    n->h = (Cost)~0;
+    n->is_wall = true;
+    n->is_goal = false;
+    n->parent = NULL;
+    n->chksum = CHKSUM;
 }
 
-void astar_init(struct Astar* astar, struct Node* grid, struct Node** openset, struct Node** closedset, uint16_t xsize, uint16_t ysize)
+void astar_init(struct Astar* astar, struct Node* grid, struct Node** openset, struct Node** closedset, uint32_t xsize, uint32_t ysize)
 {
     astar->xsize = xsize;
     astar->ysize = ysize;
@@ -105,19 +240,43 @@ void astar_init(struct Astar* astar, struct Node* grid, struct Node** openset, s
     astar->openset.len = 0;
     astar->closedset.len = 0;
 
+    // wall border, board nodes are initialized when setting points
+    for (uint32_t px=0 ; px<xsize+2 ; px++) {
+        astar_init_border(&grid[grid_i(px, 0, xsize)]);
+        astar_init_border(&grid[grid_i(px, ysize+1, xsize)]);
+    }
+    for (uint32_t py=1 ; py<=ysize ; py++) {
+        astar_init_border(&grid[grid_i(0, py, xsize)]);
+        astar_init_border(&grid[grid_i(xsize+1, py, xsize)]);
+    }
+
     // set default values for callbacks. NULL will not draw!
     astar->draw_open_cb    = NULL;
     astar->draw_closed_cb  = NULL;
     astar->draw_wall_cb    = NULL;
     astar->draw_path_cb    = NULL;
     astar->draw_refresh_cb = NULL;
+
+    astar->trace = NULL;
 }
 
-void astar_debug(struct Astar* astar)
+uint32_t astar_count_walls(struct Astar* astar)
 {
-    struct Node* n = astar->grid;
+    /* Count walls on board, border is not counted */
+    uint32_t n_wall = 0;
+    for (uint32_t y=0 ; y<astar->ysize ; y++) {
+        for (uint32_t x=0 ; x<astar->xsize ; x++)
+            n_wall += get_node(astar->grid, x, y, astar->xsize)->is_wall;
+    }
+    return n_wall;
+}
 
-    for (int i=0 ; i<astar->xsize*astar->ysize ; i++, n++) {
+void astar_debug(struct Astar* astar)
+{
+    for (int i=0 ; i<astar->xsize*astar->ysize ; i++) {
+        Pos x, y;
+        i2pos(i, &x, &y, astar->xsize);
+        struct Node* n = get_node(astar->grid, x, y, astar->xsize);
         debug("[%d] %d x %d\n", i, n->x, n->y);
     }
 }
@@ -140,7 +299,9 @@ void astar_draw(struct Astar* astar, struct Node* n_cur)
 
     if (astar->draw_wall_cb != NULL) {
         for (int i=0 ; i<astar->xsize*astar->ysize ; i++) {
-            struct Node* n = &astar->grid[i];
+            Pos x, y;
+            i2pos(i, &x, &y, astar->xsize);
+            struct Node* n = get_node(astar->grid, x, y, astar->xsize);
             if (n->is_wall)
                 astar->draw_wall_cb(n->x, n->y);
         }
@@ -209,6 +370,7 @@ struct Node* astar_find_highest_f(struct Set* set, struct Node** winner, uint32_
 void set_remove_node(struct Set* set, uint32_t node_i)
 {
     /* Remove node at index node_i from array by everything to left */
+    PROF_COUNT(PROF_SET_OPS, 1);
     for (int i=node_i ; i<set->len ; i++)
         set->set[i] = set->set[i+1];
 
@@ -218,6 +380,7 @@ void set_remove_node(struct Set* set, uint32_t node_i)
 bool set_node_exists(struct Set* set, struct Node* n)
 {
     /* Find node in set */
+    PROF_COUNT(PROF_SET_OPS, 1);
     for (int i=set->len-1 ; i>=0 ; i--) {
         if (set->set[i] == n)
             return true;
@@ -233,94 +396,370 @@ void set_add_node(struct Set* set, struct Node* n)
     }
 }
 
-void add_to_openset(struct Astar* astar, struct Node* parent, Pos x, Pos y, enum ASPathType ptype)
+static void astar_trace(struct Astar* astar, enum TraceType type, struct Node* n)
 {
-    /* move node to openset if it doesn't exist in closedset */
-    // TODO needs optimization
+    trace_add(astar->trace, type, pos2i(n->x, n->y, astar->xsize), n->g, n->f);
+}
 
-    // exit if node is not in grid
-    if (!is_in_grid(x, y, astar->xsize, astar->ysize))
-        return;
+/* Search loop and neighbour evaluation are generated once per path type,
+ * so the hot loop doesn't branch on ptype.
+ *   CMP:    < keeps shorter paths to a node, > keeps longer paths
+ *   FIND_F: picks next node from openset
+ */
+#define ASTAR_DEFINE_SEARCH(NAME, CMP, FIND_F)                                      \
+static void NAME##_add(struct Astar* astar, struct Node* parent, struct Node* n)  \
+{                                                                                   \
+    /* move node to openset if it doesn't exist in closedset */                     \
+    /* exit if node is a wall, border or is in closedlist */                        \
+    if (n->is_wall || set_node_exists(&astar->closedset, n))                        \
+        return;                                                                     \
+                                                                                    \
+    Cost cur_g = parent->g + 1;                                                     \
+    Cost cur_f = n->h + cur_g;                                                      \
+    bool in_openset = set_node_exists(&astar->openset, n);                          \
+                                                                                    \
+    /* if node has been seen before check if it already has a better path */       \
+    if ((n->parent != NULL && cur_g CMP n->g) || !in_openset) {                     \
+        n->parent = parent;                                                         \
+        n->g = cur_g;                                                               \
+        n->f = cur_f;                                                               \
+        if (!in_openset)                                                            \
+            set_add_node(&astar->openset, n);                                       \
+        if (astar->trace != NULL)                                                   \
+            astar_trace(astar, TRACE_OPEN, n);                                      \
+    }                                                                               \
+}                                                                                   \
+                                                                                    \
+static enum ASResult NAME(struct Astar* astar)                                      \
+{                                                                                   \
+    struct Node* n_start = get_node(astar->grid, astar->x0, astar->y0, AS_XSIZE(astar)); \
+    struct Set* openset = &astar->openset;                                          \
+    struct Set* closedset = &astar->closedset;                                      \
+                                                                                    \
+    /* start with start node */                                                     \
+    set_add_node(openset, n_start);                                                 \
+                                                                                    \
+    struct Node* n_cur = n_start;                                                   \
+    uint32_t n_cur_i;                                                               \
+                                                                                    \
+    /* When all nodes in openset are evaluated we either solved the maze or */     \
+    /* there is no solution */                                                      \
+    while (openset->len > 0) {                                                      \
+        FIND_F(openset, &n_cur, &n_cur_i);                                          \
+                                                                                    \
+        /* If current node is an end node it means we solved the maze */            \
+        if (n_cur->is_goal) {                                                       \
+            astar->x1 = n_cur->x;                                                   \
+            astar->y1 = n_cur->y;                                                   \
+            return AS_SOLVED;                                                       \
+        }                                                                           \
+                                                                                    \
+        set_add_node(closedset, n_cur);                                             \
+        set_remove_node(openset, n_cur_i);                                          \
+        PROF_COUNT(PROF_EXPANDED, 1);                                               \
+        if (astar->trace != NULL)                                                   \
+            astar_trace(astar, TRACE_CLOSE, n_cur);                                 \
+                                                                                    \
+        /* add neighbours of current node to openset */                             \
+        /* NOTE: there is a clear bias towards North/East because */                \
+        /*       that is wat we're checking first! */                               \
+        /* border walls make bounds checks unnecessary */                           \
+        NAME##_add(astar, n_cur, astar_neighbour(astar, n_cur, AS_DIR_N));          \
+        NAME##_add(astar, n_cur, astar_neighbour(astar, n_cur, AS_DIR_E));          \
+        NAME##_add(astar, n_cur, astar_neighbour(astar, n_cur, AS_DIR_S));          \
+        NAME##_add(astar, n_cur, astar_neighbour(astar, n_cur, AS_DIR_W));          \
+        PROF_MAX(PROF_OPEN_PEAK, openset->len);                                     \
+    }                                                                               \
+                                                                                    \
+    astar_draw(astar, n_cur);                                                       \
+    return AS_UNSOLVED;                                                             \
+}
+
+ASTAR_DEFINE_SEARCH(find_path_shortest, <, astar_find_lowest_f)
+ASTAR_DEFINE_SEARCH(find_path_longest,  >, astar_find_highest_f)
 
-    struct Node* n = get_node(astar->grid, x, y, astar->xsize);
+enum ASResult astar_find_path(struct Astar* astar, enum ASPathType ptype)
+{
+    /* Find quickest or longest path from astar->xy0 to astar->xy1, or to
+     * the first goal reached when goals were set with astar_set_goals()
+     * Path_type enum indicates longest or shortest
+     */
+#ifdef FIXED_BOARD
+    if (astar->xsize != XSIZE || astar->ysize != YSIZE)
+        return AS_ERROR;
+#endif
 
-    // exit if node is a wall
-    if (n->is_wall)
+    if (ptype == AS_SHORTEST)
+        return find_path_shortest(astar);
+    return find_path_longest(astar);
+}
+
+static uint32_t ds_h(struct DStar* ds, uint32_t a, uint32_t b)
+{
+    /* Manhattan distance between node indices */
+    uint32_t ax = a % ds->xsize, ay = a / ds->xsize;
+    uint32_t bx = b % ds->xsize, by = b / ds->xsize;
+    return ((ax > bx) ? ax - bx : bx - ax) + ((ay > by) ? ay - by : by - ay);
+}
+
+static uint32_t ds_neighbours(struct DStar* ds, uint32_t i, uint32_t* out)
+{
+    /* Get indices of neighbours within grid, N E S W order */
+    uint32_t x = i % ds->xsize;
+    uint32_t y = i / ds->xsize;
+    uint32_t n = 0;
+
+    if (y > 0)
+        out[n++] = i - ds->xsize;
+    if (x < ds->xsize-1)
+        out[n++] = i + 1;
+    if (y < ds->ysize-1)
+        out[n++] = i + ds->xsize;
+    if (x > 0)
+        out[n++] = i - 1;
+    return n;
+}
+
+static bool ds_key_less(uint32_t a1, uint32_t a2, uint32_t b1, uint32_t b2)
+{
+    return a1 < b1 || (a1 == b1 && a2 < b2);
+}
+
+static void ds_calc_key(struct DStar* ds, uint32_t i, uint32_t* k1, uint32_t* k2)
+{
+    struct DSNode* n = &ds->nodes[i];
+    uint32_t m = (n->g < n->rhs) ? n->g : n->rhs;
+
+    *k2 = m;
+    *k1 = (m == DS_INF) ? DS_INF : m + ds_h(ds, ds->start, i) + ds->km;
+}
+
+static bool ds_heap_less(struct DStar* ds, uint32_t hi, uint32_t hj)
+{
+    struct DSNode* a = &ds->nodes[ds->heap[hi]];
+    struct DSNode* b = &ds->nodes[ds->heap[hj]];
+    return ds_key_less(a->k1, a->k2, b->k1, b->k2);
+}
+
+static void ds_heap_swap(struct DStar* ds, uint32_t hi, uint32_t hj)
+{
+    uint32_t tmp = ds->heap[hi];
+    ds->heap[hi] = ds->heap[hj];
+    ds->heap[hj] = tmp;
+    ds->nodes[ds->heap[hi]].heap_i = hi;
+    ds->nodes[ds->heap[hj]].heap_i = hj;
+}
+
+static void ds_heap_fix(struct DStar* ds, uint32_t hi)
+{
+    /* Restore heap order after key at hi changed */
+    while (hi > 0 && ds_heap_less(ds, hi, (hi-1)/2)) {
+        ds_heap_swap(ds, hi, (hi-1)/2);
+        hi = (hi-1)/2;
+    }
+    while (1) {
+        uint32_t l = hi*2 + 1;
+        uint32_t r = l + 1;
+        uint32_t min = hi;
+
+        if (l < ds->heap_len && ds_heap_less(ds, l, min))
+            min = l;
+        if (r < ds->heap_len && ds_heap_less(ds, r, min))
+            min = r;
+        if (min == hi)
+            break;
+
+        ds_heap_swap(ds, hi, min);
+        hi = min;
+    }
+}
+
+static void ds_heap_remove(struct DStar* ds, uint32_t i)
+{
+    uint32_t hi = ds->nodes[i].heap_i;
+    ds->nodes[i].heap_i = DS_INF;
+
+    ds->heap_len--;
+    if (hi == ds->heap_len)
         return;
 
-    // exit if node is in closedlist
-    if (set_node_exists(&astar->closedset, n))
+    ds->heap[hi] = ds->heap[ds->heap_len];
+    ds->nodes[ds->heap[hi]].heap_i = hi;
+    ds_heap_fix(ds, hi);
+}
+
+static void ds_heap_push(struct DStar* ds, uint32_t i)
+{
+    struct DSNode* n = &ds->nodes[i];
+    ds_calc_key(ds, i, &n->k1, &n->k2);
+
+    if (n->heap_i != DS_INF) {
+        ds_heap_fix(ds, n->heap_i);
         return;
+    }
 
-    int cur_g = parent->g + 1;
-    int cur_f = n->h + cur_g;
-    bool in_openset = set_node_exists(&astar->openset, n);
+    n->heap_i = ds->heap_len;
+    ds->heap[ds->heap_len++] = i;
+    ds_heap_fix(ds, n->heap_i);
+}
 
-    // if node has been seen before check if it already has a shorter path
-    // check if one of these is true:
-    //   - new path is shorter than old path
-    //   - node is not in openset
-    
-    bool eval_g;
-    if (ptype == AS_SHORTEST)
-        eval_g = cur_g < n->g;
-    else
-        eval_g = cur_g > n->g;
-
-    if ((n->parent != NULL && eval_g) || !in_openset) {
-        n->parent = parent;
-        n->g = cur_g;
-        n->f = cur_f;
-        if (!in_openset)
-            set_add_node(&astar->openset, n);
+static void ds_update_node(struct DStar* ds, uint32_t i)
+{
+    /* Recalculate rhs from neighbours and (re)queue node if inconsistent */
+    struct DSNode* n = &ds->nodes[i];
+    uint32_t nb[4];
+
+    if (!n->is_goal) {
+        n->rhs = DS_INF;
+        for (uint32_t j=0, nn=ds_neighbours(ds, i, nb) ; j<nn ; j++) {
+            struct DSNode* s = &ds->nodes[nb[j]];
+            if (!s->is_wall && s->g != DS_INF && s->g + 1 < n->rhs)
+                n->rhs = s->g + 1;
+        }
     }
+
+    if (n->g != n->rhs)
+        ds_heap_push(ds, i);
+    else if (n->heap_i != DS_INF)
+        ds_heap_remove(ds, i);
 }
 
-enum ASResult astar_find_path(struct Astar* astar, enum ASPathType ptype)
+void dstar_init(struct DStar* ds, uint32_t xsize, uint32_t ysize)
 {
-    /* Find quickest or longest path from astar->xy0 to astar->xy1
-     * Path_type enum indicates longest or shortest
-     */
-    struct Node* n_start = get_node(astar->grid, astar->x0, astar->y0, astar->xsize);
-    struct Node* n_end = get_node(astar->grid, astar->x1, astar->y1, astar->xsize);
-
-    struct Set* openset = &astar->openset;
-    struct Set* closedset = &astar->closedset;
-
-    // start with start node
-    set_add_node(openset, n_start);
-
-    struct Node* n_cur;
-    uint32_t n_cur_i;
-
-    // When all nodes in openset are evaluated we either solved the maze or
-    // there is no solution
-    while (openset->len > 0) {
-
-        // find node with lowest or highest fscore
-        if (ptype == AS_SHORTEST)
-            astar_find_lowest_f(openset, &n_cur, &n_cur_i);
-        else
-            astar_find_highest_f(openset, &n_cur, &n_cur_i);
-
-        // If current node is equal to the end node it means we solved the maze
-        if (n_cur->x == n_end->x && n_cur->y == n_end->y)
-            return AS_SOLVED;
-
-        set_add_node(closedset, n_cur);
-        set_remove_node(openset, n_cur_i);
-
-        // add neighbours of current node to openset
-        // only if they do not eist in closedset
-        // NOTE: there is a clear bias towards North/East because
-        //       that is wat we're checking first!
-        add_to_openset(astar, n_cur, n_cur->x,   n_cur->y-1, ptype);
-        add_to_openset(astar, n_cur, n_cur->x+1, n_cur->y,   ptype);
-        add_to_openset(astar, n_cur, n_cur->x,   n_cur->y+1, ptype);
-        add_to_openset(astar, n_cur, n_cur->x-1, n_cur->y,   ptype);
+    ds->xsize = xsize;
+    ds->ysize = ysize;
+    ds->nodes = malloc(xsize*ysize * sizeof(struct DSNode));
+    ds->heap = malloc(xsize*ysize * sizeof(uint32_t));
+    ds->heap_len = 0;
+    ds->nexpanded = 0;
+}
+
+void dstar_destroy(struct DStar* ds)
+{
+    free(ds->nodes);
+    free(ds->heap);
+}
+
+void dstar_reset(struct DStar* ds, uint32_t start, const uint8_t* walls, const uint32_t* goals, uint32_t ngoals)
+{
+    /* Forget previous searches, walls is a grid of xsize*ysize bytes */
+    uint32_t size = ds->xsize*ds->ysize;
+
+    for (uint32_t i=0 ; i<size ; i++) {
+        struct DSNode* n = &ds->nodes[i];
+        n->g = DS_INF;
+        n->rhs = DS_INF;
+        n->heap_i = DS_INF;
+        n->is_wall = walls[i];
+        n->is_goal = false;
+    }
+
+    ds->heap_len = 0;
+    ds->start = start;
+    ds->last = start;
+    ds->km = 0;
+
+    for (uint32_t i=0 ; i<ngoals ; i++) {
+        ds->nodes[goals[i]].is_goal = true;
+        ds->nodes[goals[i]].rhs = 0;
+        ds_heap_push(ds, goals[i]);
     }
+}
 
-    astar_draw(astar, n_cur);
+void dstar_update_cells(struct DStar* ds, const uint32_t* cells, const bool* is_wall, uint32_t ncells)
+{
+    /* Change walls, only the cost of entering a cell changes so only
+     * its neighbours have to be updated */
+    uint32_t nb[4];
+
+    for (uint32_t ci=0 ; ci<ncells ; ci++) {
+        struct DSNode* n = &ds->nodes[cells[ci]];
+        if (n->is_wall == is_wall[ci])
+            continue;
+
+        n->is_wall = is_wall[ci];
+        for (uint32_t j=0, nn=ds_neighbours(ds, cells[ci], nb) ; j<nn ; j++)
+            ds_update_node(ds, nb[j]);
+    }
+}
+
+void dstar_move_start(struct DStar* ds, uint32_t start)
+{
+    /* Keys of queued nodes stay valid by adding the distance moved to km */
+    ds->start = start;
+    ds->km += ds_h(ds, ds->last, start);
+    ds->last = start;
+}
 
-    return AS_UNSOLVED;
+enum ASResult dstar_compute(struct DStar* ds)
+{
+    /* Expand inconsistent nodes until start is consistent and no queued
+     * node can improve it */
+    struct DSNode* n_start = &ds->nodes[ds->start];
+    uint32_t nb[4];
+
+    ds->nexpanded = 0;
+
+    while (ds->heap_len > 0) {
+        uint32_t ks1, ks2;
+        ds_calc_key(ds, ds->start, &ks1, &ks2);
+
+        uint32_t i = ds->heap[0];
+        struct DSNode* n = &ds->nodes[i];
+
+        if (!ds_key_less(n->k1, n->k2, ks1, ks2) && n_start->rhs <= n_start->g)
+            break;
+
+        uint32_t k1, k2;
+        ds_calc_key(ds, i, &k1, &k2);
+        ds->nexpanded++;
+        PROF_COUNT(PROF_EXPANDED, 1);
+
+        if (ds_key_less(n->k1, n->k2, k1, k2)) {
+            // key is outdated because start moved
+            n->k1 = k1;
+            n->k2 = k2;
+            ds_heap_fix(ds, 0);
+        }
+        else if (n->g > n->rhs) {
+            n->g = n->rhs;
+            ds_heap_remove(ds, i);
+            for (uint32_t j=0, nn=ds_neighbours(ds, i, nb) ; j<nn ; j++)
+                ds_update_node(ds, nb[j]);
+        }
+        else {
+            n->g = DS_INF;
+            ds_update_node(ds, i);
+            for (uint32_t j=0, nn=ds_neighbours(ds, i, nb) ; j<nn ; j++)
+                ds_update_node(ds, nb[j]);
+        }
+        PROF_MAX(PROF_OPEN_PEAK, ds->heap_len);
+    }
+
+    return (n_start->rhs != DS_INF) ? AS_SOLVED : AS_UNSOLVED;
+}
+
+bool dstar_next(struct DStar* ds, enum ASDir* dir)
+{
+    /* Direction of best neighbour of start, false if there is none */
+    const enum ASDir dirs[4] = {AS_DIR_N, AS_DIR_E, AS_DIR_S, AS_DIR_W};
+    uint32_t x = ds->start % ds->xsize;
+    uint32_t y = ds->start / ds->xsize;
+    uint32_t best = DS_INF;
+
+    for (int d=0 ; d<4 ; d++) {
+        uint32_t nx = x + (dirs[d] == AS_DIR_E) - (dirs[d] == AS_DIR_W);
+        uint32_t ny = y + (dirs[d] == AS_DIR_S) - (dirs[d] == AS_DIR_N);
+
+        // unsigned, so wraps at 0 and is caught by upper bound
+        if (nx >= ds->xsize || ny >= ds->ysize)
+            continue;
+
+        struct DSNode* n = &ds->nodes[ny*ds->xsize + nx];
+        if (!n->is_wall && n->g < best) {
+            best = n->g;
+            *dir = dirs[d];
+        }
+    }
+    return best != DS_INF;
 }
@@ -9,6 +9,7 @@
 #include <stdbool.h>
 
 #include "utils.h"
+#include "trace.h"
 
 // https://optimization.cbe.cornell.edu/index.php?title=A-star_algorithm
 // https://en.wikipedia.org/wiki/A*_search_algorithm#Pseudocode
@@ -31,8 +32,47 @@
  * f = g_score + h_score
  */
 
+// Board size of FIXED_BOARD builds, eg: make FIXED_BOARD=80x24
+// Strides and bounds in the search loop become constants, planner buffers
+// are statically sized and no malloc is done for A*
+#ifndef XSIZE
 #define XSIZE 50
+#endif
+#ifndef YSIZE
 #define YSIZE 50
+#endif
+
+#ifdef FIXED_BOARD
+#define AS_XSIZE(astar) ((uint32_t)XSIZE)
+#define AS_YSIZE(astar) ((uint32_t)YSIZE)
+#else
+#define AS_XSIZE(astar) ((astar)->xsize)
+#define AS_YSIZE(astar) ((astar)->ysize)
+#endif
+
+// Grid has a border of wall nodes around the board, so neighbours of
+// any board node are always in the grid. Node x,y is at padded coordinates
+// x+1,y+1, buffers passed to astar_init() need AS_GRID_SIZE(xsize, ysize)
+// nodes.
+// Row major by default, neighbours are found by adding a fixed offset.
+// With AS_TILED, eg: make TILED=1, the padded grid is stored in 8x8 tiles
+// so nodes that are near on the board are near in memory. Only the node
+// layout changes, cell indices from pos2i() stay row major.
+#define AS_TILE_SHIFT 3
+#define AS_TILE (1 << AS_TILE_SHIFT)
+#define AS_NTILES(n) (((n) + AS_TILE-1) >> AS_TILE_SHIFT)
+
+#ifdef AS_TILED
+#define AS_GRID_SIZE(xsize, ysize) (AS_NTILES((xsize)+2) * AS_NTILES((ysize)+2) * AS_TILE*AS_TILE)
+#else
+#define AS_GRID_SIZE(xsize, ysize) (((xsize)+2) * ((ysize)+2))
+#endif
+
+#ifdef FIXED_BOARD
+#define AS_STRIDE(astar) ((uint32_t)XSIZE+2)
+#else
+#define AS_STRIDE(astar) ((astar)->xsize+2)
+#endif
 
 #define CHKSUM 123456
 
@@ -47,16 +87,28 @@ enum ASPathType {
     AS_LONGEST
 };
 
-typedef uint16_t Pos;
+// Directions in a path, same order as snake's enum Direction
+enum ASDir {
+    AS_DIR_N,
+    AS_DIR_E,
+    AS_DIR_S,
+    AS_DIR_W
+};
+
+// bytes needed to store a path of n steps
+#define AS_PATH_BUFSIZE(n) (((n) + 3) / 4)
 
 struct Node {
-    uint16_t f;     // g+h
-    uint16_t g;     // cost of start->current
-    uint16_t h;     // cost of current->end
+    Cost f;     // g+h
+    Cost g;     // cost of start->current
+    Cost h;     // cost of current->end
                     
     // indicate if this node is an obstacle to move around to
     bool is_wall;
 
+    // search ends when any goal node is reached
+    bool is_goal;
+
     Pos x;
     Pos y;
 
@@ -73,15 +125,24 @@ struct Set {
     struct Node** set;
 };
 
+// Found path as a forward list of directions from start to end node,
+// packed 2 bits per step
+struct ASPath {
+    uint32_t len;
+    uint32_t size;
+    uint8_t* steps;
+};
+
 struct Astar {
-    uint16_t xsize;
-    uint16_t ysize;
+    uint32_t xsize;
+    uint32_t ysize;
 
     // start node
     Pos x0;
     Pos y0;
 
-    // end node
+    // end node, when searching for multiple goals this is the goal
+    // that was reached
     Pos x1;
     Pos y1;
 
@@ -98,18 +159,113 @@ struct Astar {
     void(*draw_wall_cb)(Pos x, Pos y);
     void(*draw_refresh_cb)();
 
+    // record opened and closed nodes, NULL doesn't trace
+    struct Trace* trace;
+};
+
+/* D* Lite, incremental replanning
+ *
+ * Searches backwards from goals to start and keeps g/rhs values between
+ * searches. When walls change or the start moves, only nodes affected by
+ * the change are expanded again. Entering a wall is impossible, leaving
+ * one is allowed so the start can be a wall, eg: the snake's head.
+ * Edges don't wrap, like in A*.
+ */
+
+#define DS_INF UINT32_MAX
+
+struct DSNode {
+    uint32_t g;
+    uint32_t rhs;
+
+    // priority queue key and position, heap_i is DS_INF if not queued
+    uint32_t k1;
+    uint32_t k2;
+    uint32_t heap_i;
+
+    bool is_wall;
+    bool is_goal;
+};
+
+struct DStar {
+    uint32_t xsize;
+    uint32_t ysize;
+
+    struct DSNode* nodes;
+
+    // binary min heap of node indices
+    uint32_t* heap;
+    uint32_t heap_len;
+
+    uint32_t start;
+    uint32_t last;
+    uint32_t km;
+
+    // nodes expanded by last dstar_compute()
+    uint32_t nexpanded;
 };
 
-void astar_init(struct Astar* astar, struct Node* grid, struct Node** openset, struct Node** closedset, uint16_t xsize, uint16_t ysize);
+static inline uint32_t grid_i(uint32_t px, uint32_t py, uint32_t xsize)
+{
+    /* Translate padded coordinates into node index */
+#ifdef AS_TILED
+    uint32_t tile = (py >> AS_TILE_SHIFT)*AS_NTILES(xsize+2) + (px >> AS_TILE_SHIFT);
+    return (tile << (2*AS_TILE_SHIFT)) + ((py & (AS_TILE-1)) << AS_TILE_SHIFT) + (px & (AS_TILE-1));
+#else
+    return py*(xsize+2) + px;
+#endif
+}
+
+static inline struct Node* astar_neighbour(struct Astar* astar, struct Node* n, enum ASDir dir)
+{
+    /* Get neighbour of board node n, is a border node at the edges */
+#ifdef AS_TILED
+    uint32_t px = n->x+1;
+    uint32_t py = n->y+1;
+    switch (dir) {
+        case AS_DIR_N: py--; break;
+        case AS_DIR_E: px++; break;
+        case AS_DIR_S: py++; break;
+        case AS_DIR_W: px--; break;
+    }
+    return &astar->grid[grid_i(px, py, AS_XSIZE(astar))];
+#else
+    switch (dir) {
+        case AS_DIR_N: return n - AS_STRIDE(astar);
+        case AS_DIR_E: return n + 1;
+        case AS_DIR_S: return n + AS_STRIDE(astar);
+        default:       return n - 1;
+    }
+#endif
+}
+
+void dstar_init(struct DStar* ds, uint32_t xsize, uint32_t ysize);
+void dstar_destroy(struct DStar* ds);
+void dstar_reset(struct DStar* ds, uint32_t start, const uint8_t* walls, const uint32_t* goals, uint32_t ngoals);
+void dstar_update_cells(struct DStar* ds, const uint32_t* cells, const bool* is_wall, uint32_t ncells);
+void dstar_move_start(struct DStar* ds, uint32_t start);
+enum ASResult dstar_compute(struct DStar* ds);
+bool dstar_next(struct DStar* ds, enum ASDir* dir);
+
+void astar_init(struct Astar* astar, struct Node* grid, struct Node** openset, struct Node** closedset, uint32_t xsize, uint32_t ysize);
 void astar_set_points(struct Astar* astar, Pos x0, Pos y0, Pos x1, Pos y1);
+void astar_set_goals(struct Astar* astar, Pos x0, Pos y0, const Pos* goals, uint32_t ngoals);
 void astar_debug(struct Astar* astar);
+uint32_t astar_count_walls(struct Astar* astar);
 enum ASResult astar_find_path(struct Astar* astar, enum ASPathType path_type);
 
-struct Node* get_node(struct Node* grid, Pos x, Pos y, uint16_t xsize);
+void astar_path_init(struct ASPath* path, uint8_t* buf, uint32_t size);
+enum ASResult astar_get_path(struct Astar* astar, struct ASPath* path);
+enum ASDir astar_path_get(struct ASPath* path, uint32_t i);
+void astar_path_set(struct ASPath* path, uint32_t i, enum ASDir dir);
+
+uint32_t pos2i(Pos x, Pos y, uint32_t xsize);
+void i2pos(uint32_t i, Pos* x, Pos* y, uint32_t xsize);
+struct Node* get_node(struct Node* grid, Pos x, Pos y, uint32_t xsize);
 void astar_draw(struct Astar* astar, struct Node* n_cur);
 
 bool set_node_exists(struct Set* set, struct Node* n);
 void set_add_node(struct Set* set, struct Node* n);
-bool is_in_grid(Pos x, Pos y, uint16_t xsize, uint16_t ysize);
+bool is_in_grid(Pos x, Pos y, uint32_t xsize, uint32_t ysize);
 
 #endif
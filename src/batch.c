@@ -0,0 +1,300 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#include "batch.h"
+#include "snake.h"
+
+static uint8_t* batch_occ(struct SnekBatch* b, uint32_t gi)
+{
+    return &b->occ[(size_t)gi * b->size];
+}
+
+static uint8_t* batch_obs(struct SnekBatch* b, uint32_t gi)
+{
+    return &b->obs[(size_t)gi * b->size];
+}
+
+static uint32_t* batch_body(struct SnekBatch* b, uint32_t gi)
+{
+    return &b->body[(size_t)gi * b->size];
+}
+
+static uint32_t batch_free_loc(struct SnekBatch* b, uint32_t gi)
+{
+    /* Same draws as get_free_loc(), but checks occupancy grid instead of lists */
+    uint8_t* occ = batch_occ(b, gi);
+    while (1) {
+        uint32_t x = rng_next(&b->rng[gi]) % b->xsize;
+        uint32_t y = rng_next(&b->rng[gi]) % b->ysize;
+        uint32_t ci = y*b->xsize + x;
+
+        if (occ[ci] == 0)
+            return ci;
+    }
+}
+
+static void batch_place_food(struct SnekBatch* b, uint32_t gi, uint32_t fi)
+{
+    uint32_t ci = batch_free_loc(b, gi);
+    b->food[gi*b->maxfood + fi] = ci;
+    batch_occ(b, gi)[ci] |= BATCH_OCC_FOOD;
+    batch_obs(b, gi)[ci] = SNEK_CELL_FOOD;
+}
+
+static void batch_game_init(struct SnekBatch* b, uint32_t gi)
+{
+    /* Same start position and food as game_init() */
+    uint32_t x = b->xsize/2;
+    uint32_t y = b->ysize/2;
+    uint32_t ci = y*b->xsize + x;
+
+    b->head_x[gi] = x;
+    b->head_y[gi] = y;
+    b->len[gi] = 1;
+    b->cur_len[gi] = 1;
+    b->score[gi] = 0;
+    b->nmoves[gi] = 0;
+    b->rng[gi] = rng_seed(b->seed[gi]);
+
+    b->tail[gi] = 0;
+    batch_body(b, gi)[0] = ci;
+    batch_occ(b, gi)[ci] = 1;
+    batch_obs(b, gi)[ci] = SNEK_CELL_HEAD;
+
+    for (uint32_t fi=0 ; fi<b->maxfood ; fi++)
+        batch_place_food(b, gi, fi);
+}
+
+static void batch_game_clear(struct SnekBatch* b, uint32_t gi)
+{
+    /* Clear occupied cells only, so a reset doesn't touch the whole grid */
+    uint8_t* occ = batch_occ(b, gi);
+    uint8_t* obs = batch_obs(b, gi);
+    uint32_t* body = batch_body(b, gi);
+
+    for (uint32_t i=0 ; i<b->cur_len[gi] ; i++) {
+        uint32_t ci = body[(b->tail[gi] + i) % b->size];
+        occ[ci] = 0;
+        obs[ci] = SNEK_CELL_EMPTY;
+    }
+    for (uint32_t fi=0 ; fi<b->maxfood ; fi++) {
+        uint32_t ci = b->food[gi*b->maxfood + fi];
+        occ[ci] = 0;
+        obs[ci] = SNEK_CELL_EMPTY;
+    }
+}
+
+struct SnekBatch* snek_batch_create(const struct SnekConfig* cfg, uint32_t n, uint32_t seed)
+{
+    uint64_t size = (uint64_t)cfg->xsize * cfg->ysize;
+
+    // same limits as snek_create()
+    if (n == 0 || cfg->xsize == 0 || cfg->ysize == 0 || cfg->maxfood == 0)
+        return NULL;
+    if (size <= (uint64_t)cfg->maxfood + 1 || size > (Cost)~0)
+        return NULL;
+
+    struct SnekBatch* b = calloc(1, sizeof(struct SnekBatch));
+    if (b == NULL)
+        return NULL;
+
+    b->n = n;
+    b->xsize = cfg->xsize;
+    b->ysize = cfg->ysize;
+    b->size = size;
+    b->maxfood = cfg->maxfood;
+    b->grow_fac = cfg->grow_fac;
+
+    b->head_x  = malloc((size_t)n * sizeof(uint32_t));
+    b->head_y  = malloc((size_t)n * sizeof(uint32_t));
+    b->len     = malloc((size_t)n * sizeof(uint32_t));
+    b->cur_len = malloc((size_t)n * sizeof(uint32_t));
+    b->score   = malloc((size_t)n * sizeof(uint32_t));
+    b->rng     = malloc((size_t)n * sizeof(uint32_t));
+    b->seed    = malloc((size_t)n * sizeof(uint32_t));
+    b->nmoves  = malloc((size_t)n * sizeof(uint64_t));
+    b->tail    = malloc((size_t)n * sizeof(uint32_t));
+    b->body    = malloc((size_t)n * size * sizeof(uint32_t));
+    b->food    = malloc((size_t)n * cfg->maxfood * sizeof(uint32_t));
+    b->occ     = calloc((size_t)n * size, sizeof(uint8_t));
+    b->obs     = calloc((size_t)n * size, sizeof(uint8_t));
+
+    // destroy frees whatever was allocated, missing arrays are NULL
+    if (b->head_x == NULL || b->head_y == NULL || b->len == NULL || b->cur_len == NULL ||
+        b->score == NULL || b->rng == NULL || b->seed == NULL || b->nmoves == NULL ||
+        b->tail == NULL || b->body == NULL || b->food == NULL || b->occ == NULL || b->obs == NULL) {
+        snek_batch_destroy(b);
+        return NULL;
+    }
+
+    for (uint32_t gi=0 ; gi<n ; gi++) {
+        b->seed[gi] = seed + gi;
+        batch_game_init(b, gi);
+    }
+    return b;
+}
+
+void snek_batch_destroy(struct SnekBatch* b)
+{
+    free(b->head_x);
+    free(b->head_y);
+    free(b->len);
+    free(b->cur_len);
+    free(b->score);
+    free(b->rng);
+    free(b->seed);
+    free(b->nmoves);
+    free(b->tail);
+    free(b->body);
+    free(b->food);
+    free(b->occ);
+
+    if (b->shm != NULL)
+        munmap(b->shm, b->shm_size);
+    else
+        free(b->obs);
+
+    free(b);
+}
+
+bool snek_batch_share(struct SnekBatch* b, const char* path)
+{
+    /* Move observation grids to a shared file mapping, so other processes
+     * can read them without copying, see struct SnekObsHeader */
+    if (b->shm != NULL)
+        return false;
+
+    size_t grids_size = (size_t)b->n * b->size;
+    size_t size = sizeof(struct SnekObsHeader) + grids_size;
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return false;
+
+    if (ftruncate(fd, size) < 0) {
+        close(fd);
+        return false;
+    }
+
+    void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return false;
+
+    struct SnekObsHeader* hdr = map;
+    memcpy(hdr->magic, SNEK_OBS_MAGIC, sizeof(hdr->magic));
+    hdr->version = SNEK_OBS_VERSION;
+    atomic_init(&hdr->seq, 0);
+    hdr->n = b->n;
+    hdr->xsize = b->xsize;
+    hdr->ysize = b->ysize;
+    hdr->offset = sizeof(struct SnekObsHeader);
+    hdr->nsteps = 0;
+
+    uint8_t* obs = (uint8_t*)map + hdr->offset;
+    memcpy(obs, b->obs, grids_size);
+    free(b->obs);
+
+    b->obs = obs;
+    b->shm = hdr;
+    b->shm_size = size;
+    return true;
+}
+
+void snek_batch_step(struct SnekBatch* b, const uint8_t* dirs, uint8_t* results)
+{
+    /* Step all games, new heads are calculated for all games first in a
+     * branchless loop without memory indirection so it vectorizes, then
+     * grids and bodies are updated game by game */
+    const uint32_t n = b->n;
+    const int32_t xsize = b->xsize;
+    const int32_t ysize = b->ysize;
+    uint32_t* restrict hx = b->head_x;
+    uint32_t* restrict hy = b->head_y;
+    const uint8_t* restrict vd = dirs;
+
+    // mark grids as being written for shm readers
+    if (b->shm != NULL)
+        atomic_fetch_add_explicit(&b->shm->seq, 1, memory_order_acq_rel);
+
+    for (uint32_t gi=0 ; gi<n ; gi++) {
+        uint8_t d = vd[gi] & 3;
+        int32_t x = (int32_t)hx[gi] + (d == DIR_E) - (d == DIR_W);
+        int32_t y = (int32_t)hy[gi] + (d == DIR_S) - (d == DIR_N);
+
+        // wrap around edges, like get_newxy()
+        x += xsize & -(x < 0);
+        x -= xsize & -(x >= xsize);
+        y += ysize & -(y < 0);
+        y -= ysize & -(y >= ysize);
+
+        hx[gi] = x;
+        hy[gi] = y;
+    }
+
+    for (uint32_t gi=0 ; gi<n ; gi++) {
+        uint8_t* occ = batch_occ(b, gi);
+        uint8_t* obs = batch_obs(b, gi);
+        uint32_t* body = batch_body(b, gi);
+        uint32_t ci = hy[gi]*b->xsize + hx[gi];
+        enum SnekResult res = SNEK_RUNNING;
+
+        b->nmoves[gi]++;
+
+        // old head becomes body
+        obs[body[(b->tail[gi] + b->cur_len[gi] - 1) % b->size]] = SNEK_CELL_BODY;
+
+        // grow or move
+        body[(b->tail[gi] + b->cur_len[gi]) % b->size] = ci;
+        occ[ci]++;
+        if (b->cur_len[gi] < b->len[gi]) {
+            b->cur_len[gi]++;
+        }
+        else {
+            uint32_t ti = body[b->tail[gi]];
+            if (--occ[ti] == 0)
+                obs[ti] = SNEK_CELL_EMPTY;
+            b->tail[gi] = (b->tail[gi] + 1) % b->size;
+        }
+        obs[ci] = SNEK_CELL_HEAD;
+
+        // detect full field
+        if (b->cur_len[gi] + b->maxfood >= b->size) {
+            res = SNEK_WON;
+        }
+        else {
+            // detect collision with food item, new food is placed before
+            // the eaten one is removed, like game_next() does
+            if (occ[ci] & BATCH_OCC_FOOD) {
+                b->len[gi] += b->grow_fac;
+                b->score[gi]++;
+
+                uint32_t* food = &b->food[gi*b->maxfood];
+                uint32_t fi = 0;
+                while (food[fi] != ci)
+                    fi++;
+
+                batch_place_food(b, gi, fi);
+                occ[ci] &= ~BATCH_OCC_FOOD;
+            }
+
+            // detect collision with snake body
+            if ((occ[ci] & BATCH_OCC_BODY) > 1)
+                res = SNEK_LOST;
+        }
+
+        if (results != NULL)
+            results[gi] = res;
+
+        if (res != SNEK_RUNNING) {
+            batch_game_clear(b, gi);
+            b->seed[gi] += n;
+            batch_game_init(b, gi);
+        }
+    }
+
+    if (b->shm != NULL) {
+        b->shm->nsteps++;
+        atomic_fetch_add_explicit(&b->shm->seq, 1, memory_order_release);
+    }
+}
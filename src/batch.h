@@ -0,0 +1,115 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#include "snek.h"
+
+/* Batch environment, steps N games in lockstep
+ *
+ * Game state is stored as struct of arrays, one entry per game, so the
+ * per game logic of game_next() runs as loops over plain arrays. Bodies
+ * are ring buffers of cell indices, occupancy grids replace the linked
+ * list lookups of snake.c. Same seed and moves give the same games as
+ * game_next().
+ *
+ * Finished games are reset in the same call, game i is seeded with
+ * seed+i and every reset adds n to its seed.
+ */
+
+#define SNEK_OBS_MAGIC "SNKO"
+#define SNEK_OBS_VERSION 1
+
+/* Observation grids in a shared file, eg: /dev/shm/snek.obs
+ *
+ * Header is followed by n grids of xsize*ysize enum SnekCell values.
+ * seq is odd while a step is writing, readers read grids in place and
+ * retry when seq changed in the meantime:
+ *
+ *     uint64_t seq;
+ *     do {
+ *         seq = snek_obs_read_begin(hdr);
+ *         ... read grids ...
+ *     } while (snek_obs_read_retry(hdr, seq));
+ */
+struct SnekObsHeader {
+    char magic[4];
+    uint32_t version;
+    _Atomic uint64_t seq;
+    uint32_t n;
+    uint32_t xsize;
+    uint32_t ysize;
+    uint32_t offset;    // offset of first grid from start of header
+    uint64_t nsteps;
+};
+
+static inline uint64_t snek_obs_read_begin(const struct SnekObsHeader* hdr)
+{
+    uint64_t seq;
+    while ((seq = atomic_load_explicit(&hdr->seq, memory_order_acquire)) & 1)
+        ;
+    return seq;
+}
+
+static inline bool snek_obs_read_retry(const struct SnekObsHeader* hdr, uint64_t seq)
+{
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&hdr->seq, memory_order_relaxed) != seq;
+}
+
+// occupancy grid cell: amount of body segments, food flag in highest bit
+#define BATCH_OCC_FOOD 0x80
+#define BATCH_OCC_BODY 0x7f
+
+struct SnekBatch {
+    uint32_t n;
+    uint32_t xsize;
+    uint32_t ysize;
+    uint32_t size;
+    uint16_t maxfood;
+    uint8_t grow_fac;
+
+    // per game state, n entries each
+    uint32_t* head_x;
+    uint32_t* head_y;
+    uint32_t* len;
+    uint32_t* cur_len;
+    uint32_t* score;
+    uint32_t* rng;
+    uint32_t* seed;
+    uint64_t* nmoves;
+
+    // index of snake's tail in body ring
+    uint32_t* tail;
+
+    // n rings of size cell indices, tail to head
+    uint32_t* body;
+
+    // n*maxfood cell indices of food items
+    uint32_t* food;
+
+    // n grids of size cells
+    uint8_t* occ;
+
+    // n observation grids of size enum SnekCell values, maintained
+    // incrementally, lives in shm when shared
+    uint8_t* obs;
+    struct SnekObsHeader* shm;
+    size_t shm_size;
+};
+
+// NULL on invalid config or when out of memory
+struct SnekBatch* snek_batch_create(const struct SnekConfig* cfg, uint32_t n, uint32_t seed);
+void snek_batch_destroy(struct SnekBatch* batch);
+
+// move observation grids into a shared file, false on error
+bool snek_batch_share(struct SnekBatch* batch, const char* path);
+
+// step all games, dirs are masked to 2 bits, results of finished games
+// are WON or LOST and these games are already reset on return
+void snek_batch_step(struct SnekBatch* batch, const uint8_t* dirs, uint8_t* results);
+
+#endif
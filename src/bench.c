@@ -0,0 +1,332 @@
+#include "bench.h"
+#include "bot.h"
+
+// bot callbacks have no user argument, so sampling state lives here
+static struct Corpus* sample_corpus;
+static struct State sample_state;
+static uint32_t sample_interval;
+static uint64_t sample_moves;
+
+static uint64_t bench_now_ns()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec*1000000000 + t.tv_nsec;
+}
+
+static void corpus_add(struct Corpus* corpus, struct Game* game)
+{
+    /* Store copy of current board position */
+    if (corpus->npos == corpus->size) {
+        corpus->size = (corpus->size > 0) ? corpus->size*2 : 64;
+        corpus->pos = realloc(corpus->pos, corpus->size * sizeof(struct BenchPos));
+    }
+
+    struct BenchPos* pos = &corpus->pos[corpus->npos++];
+    pos->len = game->snake.len;
+    pos->cur_len = 0;
+    pos->nfood = 0;
+
+    for (struct Seg* seg = *game->snake.shead ; seg != NULL ; seg = seg->next)
+        pos->cur_len++;
+    for (struct FoodItem* f = *game->food.fhead ; f != NULL ; f = f->next)
+        pos->nfood++;
+
+    pos->body = malloc(pos->cur_len * 2 * sizeof(Pos));
+    pos->food = malloc(pos->nfood * 2 * sizeof(Pos));
+
+    Pos* p = pos->body;
+    for (struct Seg* seg = *game->snake.shead ; seg != NULL ; seg = seg->next) {
+        *p++ = seg->xpos;
+        *p++ = seg->ypos;
+    }
+
+    p = pos->food;
+    for (struct FoodItem* f = *game->food.fhead ; f != NULL ; f = f->next) {
+        *p++ = f->xpos;
+        *p++ = f->ypos;
+    }
+}
+
+static void sample_cb(struct Game* game, char* status)
+{
+    /* Called by bot after every move */
+    sample_moves++;
+
+    if (sample_moves % sample_interval == 0)
+        corpus_add(sample_corpus, game);
+
+    if (sample_moves >= BENCH_MAX_MOVES)
+        sample_state.is_stopped = true;
+}
+
+bool corpus_create(struct Corpus* corpus, struct State* state, uint32_t xsize, uint32_t ysize, uint32_t ngames, uint32_t interval)
+{
+    /* Play headless bot games with seeds state->seed..seed+ngames and sample
+     * board position every interval moves */
+    corpus->xsize = xsize;
+    corpus->ysize = ysize;
+    corpus->npos = 0;
+    corpus->size = 0;
+    corpus->pos = NULL;
+
+    struct State* s = &sample_state;
+    *s = *state;
+    s->speed_ms = 0;
+
+    // we need to see every move
+    s->frame_skip = 1;
+    s->fps = 0;
+
+    sample_corpus = corpus;
+    sample_interval = (interval > 0) ? interval : 1;
+
+    for (uint32_t i=0 ; i<ngames ; i++) {
+        struct Game game;
+        struct Bot bot;
+
+        game_init(&game, xsize, ysize, s->max_food, state->seed+i);
+        game.grow_fac = s->grow_amount;
+
+        s->is_stopped = false;
+        sample_moves = 0;
+
+        bot_init(&bot, &game, s, xsize, ysize);
+        bot.publish_cb = &sample_cb;
+
+        enum BotResult res = bot_run(&bot);
+        log_info("corpus: game %u seed=%u result=%d score=%d moves=%lu positions=%u\n",
+                 i, state->seed+i, res, game.score, (unsigned long)sample_moves, corpus->npos);
+
+        bot_destroy(&bot);
+        game_destroy(&game);
+    }
+
+    sample_corpus = NULL;
+    return true;
+}
+
+static bool write_u32(FILE* fp, uint32_t v)
+{
+    return fwrite(&v, sizeof(v), 1, fp) == 1;
+}
+
+static bool write_pos(FILE* fp, Pos* p, uint32_t n)
+{
+    for (uint32_t i=0 ; i<n ; i++) {
+        if (!write_u32(fp, p[i]))
+            return false;
+    }
+    return true;
+}
+
+bool corpus_write(struct Corpus* corpus, char* path)
+{
+    FILE* fp = fopen(path, "wb");
+    if (fp == NULL)
+        return false;
+
+    bool is_ok = write_u32(fp, BENCH_MAGIC) && write_u32(fp, BENCH_VERSION) &&
+                 write_u32(fp, corpus->xsize) && write_u32(fp, corpus->ysize) &&
+                 write_u32(fp, corpus->npos);
+
+    for (uint32_t i=0 ; is_ok && i<corpus->npos ; i++) {
+        struct BenchPos* pos = &corpus->pos[i];
+        is_ok = write_u32(fp, pos->len) && write_u32(fp, pos->cur_len) && write_u32(fp, pos->nfood) &&
+                write_pos(fp, pos->body, pos->cur_len*2) && write_pos(fp, pos->food, pos->nfood*2);
+    }
+
+    return (fclose(fp) == 0) && is_ok;
+}
+
+static bool read_u32(FILE* fp, uint32_t* v)
+{
+    return fread(v, sizeof(*v), 1, fp) == 1;
+}
+
+static bool read_pos(FILE* fp, Pos* p, uint32_t n)
+{
+    uint32_t v;
+    for (uint32_t i=0 ; i<n ; i++) {
+        if (!read_u32(fp, &v))
+            return false;
+        p[i] = v;
+    }
+    return true;
+}
+
+bool corpus_load(struct Corpus* corpus, char* path)
+{
+    FILE* fp = fopen(path, "rb");
+    if (fp == NULL)
+        return false;
+
+    uint32_t magic, version;
+    corpus->npos = 0;
+    corpus->size = 0;
+    corpus->pos = NULL;
+
+    if (!read_u32(fp, &magic) || !read_u32(fp, &version) || magic != BENCH_MAGIC || version != BENCH_VERSION) {
+        log_error("Not a corpus file: %s\n", path);
+        fclose(fp);
+        return false;
+    }
+
+    uint32_t npos;
+    bool is_ok = read_u32(fp, &corpus->xsize) && read_u32(fp, &corpus->ysize) && read_u32(fp, &npos);
+
+    if (is_ok) {
+        corpus->size = npos;
+        corpus->pos = calloc(npos, sizeof(struct BenchPos));
+    }
+
+    for (uint32_t i=0 ; is_ok && i<npos ; i++) {
+        struct BenchPos* pos = &corpus->pos[i];
+        is_ok = read_u32(fp, &pos->len) && read_u32(fp, &pos->cur_len) && read_u32(fp, &pos->nfood);
+        if (!is_ok)
+            break;
+
+        pos->body = malloc(pos->cur_len * 2 * sizeof(Pos));
+        pos->food = malloc(pos->nfood * 2 * sizeof(Pos));
+        corpus->npos++;
+
+        is_ok = read_pos(fp, pos->body, pos->cur_len*2) && read_pos(fp, pos->food, pos->nfood*2);
+    }
+
+    fclose(fp);
+
+    if (!is_ok) {
+        log_error("Corpus file is truncated: %s\n", path);
+        corpus_destroy(corpus);
+    }
+    return is_ok;
+}
+
+void corpus_destroy(struct Corpus* corpus)
+{
+    for (uint32_t i=0 ; i<corpus->npos ; i++) {
+        free(corpus->pos[i].body);
+        free(corpus->pos[i].food);
+    }
+    free(corpus->pos);
+    corpus->pos = NULL;
+    corpus->npos = 0;
+}
+
+static void bench_set_walls(struct Astar* astar, struct BenchPos* pos, bool incl_tail)
+{
+    /* Mark snake body as wall, head is the last segment and is never a wall */
+    for (uint32_t i=(incl_tail ? 0 : 1) ; i<pos->cur_len-1 ; i++) {
+        struct Node* n = get_node(astar->grid, pos->body[i*2], pos->body[i*2+1], astar->xsize);
+        n->is_wall = true;
+    }
+}
+
+static enum ASResult bench_plan(struct Astar* astar, struct BenchPos* pos, enum ASPathType ptype, Pos xend, Pos yend, bool incl_tail, uint32_t* path_len)
+{
+    Pos* head = &pos->body[(pos->cur_len-1)*2];
+
+    astar_set_points(astar, head[0], head[1], xend, yend);
+    bench_set_walls(astar, pos, incl_tail);
+
+    enum ASResult res = astar_find_path(astar, ptype);
+    if (res == AS_SOLVED)
+        *path_len = get_node(astar->grid, xend, yend, astar->xsize)->g;
+    return res;
+}
+
+static enum ASResult plan_shortest_food(struct Astar* astar, struct BenchPos* pos, uint32_t* path_len)
+{
+    bool is_growing = pos->cur_len < pos->len;
+    return bench_plan(astar, pos, AS_SHORTEST, pos->food[0], pos->food[1], is_growing, path_len);
+}
+
+static enum ASResult plan_nearest_food(struct Astar* astar, struct BenchPos* pos, uint32_t* path_len)
+{
+    /* One search towards all food items, ends at the nearest */
+    Pos* head = &pos->body[(pos->cur_len-1)*2];
+
+    astar_set_goals(astar, head[0], head[1], pos->food, pos->nfood);
+    bench_set_walls(astar, pos, pos->cur_len < pos->len);
+
+    enum ASResult res = astar_find_path(astar, AS_SHORTEST);
+    if (res == AS_SOLVED)
+        *path_len = get_node(astar->grid, astar->x1, astar->y1, astar->xsize)->g;
+    return res;
+}
+
+static enum ASResult plan_longest_tail(struct Astar* astar, struct BenchPos* pos, uint32_t* path_len)
+{
+    return bench_plan(astar, pos, AS_LONGEST, pos->body[0], pos->body[1], false, path_len);
+}
+
+static enum ASResult plan_bot(struct Astar* astar, struct BenchPos* pos, uint32_t* path_len)
+{
+    /* Same choice as planner_plan() makes */
+    if (pos->len < PLANNER_LONGEST_LEN)
+        return plan_nearest_food(astar, pos, path_len);
+    return plan_longest_tail(astar, pos, path_len);
+}
+
+static struct BenchPlanner bench_planners[] = {
+    {"astar-bot",        &plan_bot},
+    {"astar-short-food", &plan_shortest_food},
+    {"astar-near-food",  &plan_nearest_food},
+    {"astar-long-tail",  &plan_longest_tail},
+};
+
+void bench_run(struct Corpus* corpus, FILE* out)
+{
+    /* Run all planners on all positions in corpus and report */
+#ifdef FIXED_BOARD
+    if (corpus->xsize != XSIZE || corpus->ysize != YSIZE) {
+        fprintf(out, "Corpus board %ux%u doesn't match FIXED_BOARD %ux%u\n", corpus->xsize, corpus->ysize, XSIZE, YSIZE);
+        return;
+    }
+#endif
+
+    uint32_t size = corpus->xsize*corpus->ysize;
+    struct Node* grid = malloc(AS_GRID_SIZE(corpus->xsize, corpus->ysize) * sizeof(struct Node));
+    struct Node** openset = malloc(size * sizeof(struct Node*));
+    struct Node** closedset = malloc(size * sizeof(struct Node*));
+
+    fprintf(out, "corpus: %u positions on %ux%u board\n", corpus->npos, corpus->xsize, corpus->ysize);
+    fprintf(out, "%-18s %8s %8s %12s %10s %12s %10s %10s %10s\n",
+            "planner", "plans", "solved", "total_ms", "us/plan", "expanded", "exp/plan", "kexp/s", "path_len");
+
+    for (uint32_t pi=0 ; pi<sizeof(bench_planners)/sizeof(bench_planners[0]) ; pi++) {
+        struct BenchPlanner* planner = &bench_planners[pi];
+        uint64_t t_total = 0;
+        uint64_t nexpanded = 0;
+        uint64_t sum_len = 0;
+        uint32_t nsolved = 0;
+
+        for (uint32_t i=0 ; i<corpus->npos ; i++) {
+            struct Astar astar;
+            uint32_t path_len = 0;
+
+            uint64_t t_start = bench_now_ns();
+            astar_init(&astar, grid, openset, closedset, corpus->xsize, corpus->ysize);
+            enum ASResult res = planner->plan(&astar, &corpus->pos[i], &path_len);
+            t_total += bench_now_ns() - t_start;
+
+            nexpanded += astar.closedset.len;
+            if (res == AS_SOLVED) {
+                nsolved++;
+                sum_len += path_len;
+            }
+        }
+
+        uint32_t nplans = (corpus->npos > 0) ? corpus->npos : 1;
+        fprintf(out, "%-18s %8u %8u %12.2f %10.2f %12lu %10.1f %10.1f %10.1f\n",
+                planner->name, corpus->npos, nsolved,
+                t_total / 1e6, t_total / 1e3 / nplans,
+                (unsigned long)nexpanded, (double)nexpanded / nplans,
+                (t_total > 0) ? nexpanded * 1e6 / t_total : 0.0,
+                (nsolved > 0) ? (double)sum_len / nsolved : 0.0);
+    }
+
+    free(grid);
+    free(openset);
+    free(closedset);
+}
@@ -0,0 +1,69 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "astar.h"
+#include "snake.h"
+#include "state.h"
+
+/* Planner regression benchmark
+ *
+ * A corpus is built by sampling board positions at a fixed move interval
+ * from headless bot games with consecutive seeds. Every registered planner
+ * is then run on all positions in the corpus, so we benchmark the planners
+ * on realistic late game obstacle layouts instead of empty boards.
+ *
+ * Corpus file layout, all fields are uint32_t in host byte order:
+ *   header:   magic, version, xsize, ysize, npos
+ *   position: len, cur_len, nfood, body (x,y)*cur_len tail first, food (x,y)*nfood
+ */
+
+#define BENCH_MAGIC 0x434b4e53  // "SNKC"
+#define BENCH_VERSION 1
+
+#define BENCH_DEFAULT_XSIZE 80
+#define BENCH_DEFAULT_YSIZE 24
+#define BENCH_DEFAULT_GAMES 20
+#define BENCH_DEFAULT_INTERVAL 100
+
+// stop games that go on forever
+#define BENCH_MAX_MOVES 10000
+
+struct BenchPos {
+    uint32_t len;
+    uint32_t cur_len;
+    uint32_t nfood;
+
+    // coordinate pairs
+    Pos* body;
+    Pos* food;
+};
+
+struct Corpus {
+    uint32_t xsize;
+    uint32_t ysize;
+
+    uint32_t npos;
+    uint32_t size;
+    struct BenchPos* pos;
+};
+
+struct BenchPlanner {
+    char* name;
+
+    // plan on position, returns result and sets path length
+    enum ASResult(*plan)(struct Astar* astar, struct BenchPos* pos, uint32_t* path_len);
+};
+
+bool corpus_create(struct Corpus* corpus, struct State* state, uint32_t xsize, uint32_t ysize, uint32_t ngames, uint32_t interval);
+bool corpus_write(struct Corpus* corpus, char* path);
+bool corpus_load(struct Corpus* corpus, char* path);
+void corpus_destroy(struct Corpus* corpus);
+
+void bench_run(struct Corpus* corpus, FILE* out);
+
+#endif
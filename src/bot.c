@@ -1,31 +1,92 @@
 #include "bot.h"
+#include "prof.h"
+
+static uint64_t bot_now_ns()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec*1000000000 + t.tv_nsec;
+}
 
 void bot_init(struct Bot* bot, struct Game* game, struct State* state, uint32_t xsize, uint32_t ysize)
+{
+    /* Init bot with strategy from state, unknown names are rejected by
+     * main so fall back to default */
+    const struct BotStrategy* strategy = bot_strategy_find((state->strategy != NULL) ? state->strategy : BOT_DEFAULT_STRATEGY);
+    if (strategy == NULL)
+        strategy = bot_strategy_get(0);
+
+    bot_init_strategy(bot, game, state, strategy, xsize, ysize);
+}
+
+void bot_init_strategy(struct Bot* bot, struct Game* game, struct State* state, const struct BotStrategy* strategy, uint32_t xsize, uint32_t ysize)
 {
     bot->xsize = xsize;
     bot->ysize = ysize;
 
     bot->game = game;
     bot->state = state;
-}
+    bot->is_stopped = &state->is_stopped;
 
-enum Direction pos_to_dir(Pos x0, Pos y0, Pos x1, Pos y1)
-{
-    if (x0 == x1 && y0 > y1)
-        return DIR_N;
-    else if (x0 == x1 && y0 < y1)
-        return DIR_S;
-    else if (x0 < x1 && y0 == y1)
-        return DIR_E;
-    else if (x0 > x1 && y0 == y1)
-        return DIR_W;
-    else
-        return DIR_NONE;
+    bot->status[0] = '\0';
+    bot->publish_cb = NULL;
+    bot->t_publish = 0;
+
+    bot->nmoves = 0;
+    bot->nplans = 0;
+    bot->t_rate = bot_now_ns();
+    bot->nmoves_rate = 0;
+    bot->nplans_rate = 0;
+    bot->moves_per_sec = 0;
+    bot->plans_per_sec = 0;
+
+    bot->os_len = 0;
+    bot->cs_len = 0;
+    bot->perc_occ = 0;
+
+    bot->metrics = NULL;
+
+    bot->ckpt = NULL;
+    bot->is_resumed = false;
+    bot->resume_i = 0;
+
+    sched_init(&bot->sched, state->speed_ms*1000);
+
+    bot->max_idle_moves = 0;
+    bot->idle_nmoves = 0;
+    bot->idle_score = game->score;
+
+    planner_init(&bot->planner, xsize, ysize);
+
+    bot->strategy = strategy;
+
+    // tuned threshold overrides strategy, see tune_load()
+    bot->planner.longest_len = (state->longest_len > 0) ? state->longest_len : strategy->longest_len;
+    bot->use_dfield = false;
+    bot->use_dstar = false;
+    // -a applies to all strategies in a tournament, but has nothing to
+    // judge on single steps
+    bot->use_artic = (bot->strategy->use_artic || state->use_artic) && !bot->strategy->is_single_step;
+
+    if (bot->strategy->init != NULL)
+        bot->strategy->init(bot);
+
+    if (bot->use_artic) {
+        artic_init(&bot->artic, xsize, ysize);
+        bot->ar_nchecks = 0;
+        bot->ar_nrejects = 0;
+    }
 }
 
-static void draw_bar(WINDOW* win, char* str)
+void bot_destroy(struct Bot* bot)
 {
-    add_str(win, 0, 0, CGREEN, CDEFAULT, "%s", str);
+    planner_destroy(&bot->planner);
+
+    if (bot->strategy->destroy != NULL)
+        bot->strategy->destroy(bot);
+
+    if (bot->use_artic)
+        artic_destroy(&bot->artic);
 }
 
 uint32_t count_reachable(struct Astar* astar, struct Set* closedset, struct Node* n_cur)
@@ -33,32 +94,18 @@ uint32_t count_reachable(struct Astar* astar, struct Set* closedset, struct Node
     /* Recursive count of reachable nodes in grid starting from node n */
     uint32_t amount = 0;
 
-    if (set_node_exists(closedset, n_cur))
+    // walls are checked first so border nodes never end up in closedset
+    if (n_cur->is_wall || set_node_exists(closedset, n_cur))
         return amount;
 
     set_add_node(closedset, n_cur);
 
-    if (n_cur->is_wall)
-        return amount;
-
     amount++;
     astar->draw_open_cb(n_cur->x, n_cur->y);
 
-    // check all neighboring nodes
-    int8_t xy[4][2] = {{0,-1}, {1,0}, {0,1}, {-1,0}};
-
-    for (int i=0 ; i<4 ; i++) {
-
-        Pos x = n_cur->x + xy[i][0];
-        Pos y = n_cur->y + xy[i][1];
-
-        if (!is_in_grid(x, y, astar->xsize, astar->ysize))
-            continue;
-
-        struct Node* n_neighbor = get_node(astar->grid, x, y, astar->xsize);
-
-        amount += count_reachable(astar, closedset, n_neighbor);
-    }
+    // check all neighboring nodes, border walls stop the recursion at the edges
+    for (enum ASDir dir=AS_DIR_N ; dir<=AS_DIR_W ; dir++)
+        amount += count_reachable(astar, closedset, astar_neighbour(astar, n_cur, dir));
 
     return amount;
 }
@@ -74,11 +121,7 @@ float get_reachable(struct Astar* astar, struct Node* n_cur)
     }
 
     // count all nodes marked as wall
-    int n_wall = 0;
-    for (int i=0 ; i<astar->xsize*astar->ysize ; i++) {
-        if (astar->grid[i].is_wall)
-            n_wall++;
-    }
+    int n_wall = astar_count_walls(astar);
 
     // calculate unoccupied nodes (not wall)
     int unoccupied = astar->xsize*astar->ysize - n_wall;
@@ -96,25 +139,257 @@ float get_reachable(struct Astar* astar, struct Node* n_cur)
     return ((float)amount/unoccupied)*100;
 }
 
-enum GameState exec_path(struct Game* game, struct Node* n_end, WINDOW* win, float speed_ms)
+static void bot_update_rates(struct Bot* bot, uint64_t now)
+{
+    /* Update rates once per second */
+    uint64_t dt = now - bot->t_rate;
+
+    if (dt >= 1000000000) {
+        bot->moves_per_sec = (bot->nmoves - bot->nmoves_rate) * 1e9 / dt;
+        bot->plans_per_sec = (bot->nplans - bot->nplans_rate) * 1e9 / dt;
+        bot->nmoves_rate = bot->nmoves;
+        bot->nplans_rate = bot->nplans;
+        bot->t_rate = now;
+    }
+}
+
+static void bot_update_status(struct Bot* bot, uint64_t now)
+{
+    /* Update rates and format status line */
+    bot_update_rates(bot, now);
+
+    snprintf(bot->status, sizeof(bot->status), "i: %lu  snek_len: %d  score: %d, os_len: %d, cs_len: %d, occ: %.2f%%  steps/s: %.0f  plans/s: %.0f",
+             (unsigned long)bot->nplans, bot->game->snake.len, bot->game->score, bot->os_len, bot->cs_len, bot->perc_occ, bot->moves_per_sec, bot->plans_per_sec);
+
+    if (bot->use_dfield) {
+        struct DField* df = &bot->dfield;
+        size_t len = strlen(bot->status);
+        snprintf(bot->status + len, sizeof(bot->status) - len, "  df hit: %.1f%%",
+                 (df->nupdates > 0) ? 100.0 * df->nhits / df->nupdates : 0.0);
+    }
+
+    if (bot->use_dstar) {
+        size_t len = strlen(bot->status);
+        snprintf(bot->status + len, sizeof(bot->status) - len, "  ds exp/plan: %.1f",
+                 (bot->ds_nplans > 0) ? (double)bot->ds_nexpanded / bot->ds_nplans : 0.0);
+    }
+
+    if (bot->use_artic) {
+        size_t len = strlen(bot->status);
+        snprintf(bot->status + len, sizeof(bot->status) - len, "  cut rejects: %lu",
+                 (unsigned long)bot->ar_nrejects);
+    }
+}
+
+static void bot_publish(struct Bot* bot, bool is_forced)
+{
+    /* Publish every frame_skip moves, but no more often than fps allows */
+    if (bot->publish_cb == NULL)
+        return;
+
+    if (!is_forced && bot->state->frame_skip > 1 && bot->nmoves % bot->state->frame_skip != 0)
+        return;
+
+    uint64_t now = bot_now_ns();
+
+    if (!is_forced && bot->state->fps > 0) {
+        if (now < bot->t_publish)
+            return;
+        bot->t_publish = now + 1000000000 / bot->state->fps;
+    }
+
+    bot_update_status(bot, now);
+    bot->publish_cb(bot->game, bot->status);
+}
+
+static bool bot_step_cell(struct Bot* bot, uint32_t ci, enum ASDir dir, uint32_t* out)
+{
+    /* Get cell next to ci in direction dir, false if outside of field */
+    uint32_t x = ci % bot->xsize;
+    uint32_t y = ci / bot->xsize;
+
+    switch (dir) {
+        case AS_DIR_N:
+            if (y == 0) return false;
+            *out = ci - bot->xsize;
+            break;
+        case AS_DIR_E:
+            if (x == bot->xsize-1) return false;
+            *out = ci + 1;
+            break;
+        case AS_DIR_S:
+            if (y == bot->ysize-1) return false;
+            *out = ci + bot->xsize;
+            break;
+        case AS_DIR_W:
+            if (x == 0) return false;
+            *out = ci - 1;
+            break;
+    }
+    return true;
+}
+
+static bool bot_artic_reject(struct Bot* bot, struct ASPath* path, uint32_t i, enum ASDir* dir)
 {
-    /* Execute found path in snake game */
-    enum GameState gs;
+    /* Check if step i moves into a cut cell and the step after that leads
+     * into the smaller region. If so, dir is set to the free neighbour
+     * of head that leaves the most space behind */
+    struct Artic* ar = &bot->artic;
+    uint32_t head = planner_head_cell(bot->game);
+    uint32_t c, w;
+
+    // last step of a path has no follow up to judge the split by
+    if (i+1 >= path->len)
+        return false;
+
+    artic_update(ar, bot->game);
+    bot->ar_nchecks++;
+
+    if (!bot_step_cell(bot, head, astar_path_get(path, i), &c) || ar->wall[c] || !ar->is_cut[c])
+        return false;
+    if (!bot_step_cell(bot, c, astar_path_get(path, i+1), &w) || ar->wall[w])
+        return false;
+
+    uint32_t best = artic_best_space(ar, c);
+    if (artic_space(ar, c, w) >= best)
+        return false;
+
+    bool is_found = false;
+    for (enum ASDir d=AS_DIR_N ; d<=AS_DIR_W ; d++) {
+        uint32_t n;
+        if (!bot_step_cell(bot, head, d, &n) || ar->wall[n] || n == c)
+            continue;
 
-    for (int gi=1 ; gi<=n_end->g ; gi++) {
+        uint32_t space = artic_best_space(ar, n);
+        if (space > best) {
+            best = space;
+            *dir = d;
+            is_found = true;
+        }
+    }
 
-        struct Node* n = n_end;
+    // path already is the best move there is
+    if (!is_found)
+        return false;
+
+    bot->ar_nrejects++;
+    return true;
+}
 
-        while (n->g != gi)
-            n = n->parent;
+static void bot_update_metrics(struct Bot* bot)
+{
+    /* Publish game progress to metrics page */
+    struct SnekMetrics* m = bot->metrics;
+    uint64_t now = bot_now_ns();
+
+    bot_update_rates(bot, now);
+
+    metrics_write_begin(m);
+    m->t_update_ns = now;
+    m->score = bot->game->score;
+    m->len = bot->game->snake.len;
+    m->nmoves = bot->nmoves;
+    m->moves_per_sec = bot->moves_per_sec;
+    m->plans_per_sec = bot->plans_per_sec;
+    metrics_write_end(m);
+}
 
-        // apply move
-        gs = game_next(game, pos_to_dir(n->parent->x, n->parent->y, n->x, n->y));
+static void bot_update_plan_metrics(struct Bot* bot, enum ASResult res, uint64_t plan_ns)
+{
+    /* Publish result of last plan to metrics page */
+    struct SnekMetrics* m = bot->metrics;
+
+    metrics_write_begin(m);
+    m->nplans = bot->nplans;
+    if (res != AS_SOLVED)
+        m->nfailures++;
+    m->plan_ns_last = plan_ns;
+    if (plan_ns > m->plan_ns_max)
+        m->plan_ns_max = plan_ns;
+    if (bot->os_len > m->os_peak)
+        m->os_peak = bot->os_len;
+    if (bot->cs_len > m->cs_peak)
+        m->cs_peak = bot->cs_len;
+    metrics_write_end(m);
+}
 
-        werase(win);
-        game_draw(game);
-        wrefresh(win);
-        usleep(speed_ms*1000);
+static enum BotResult bot_finish_metrics(struct Bot* bot, enum BotResult res)
+{
+    /* Publish final result to metrics page */
+    const enum MetricsResult results[] = {METRICS_WON, METRICS_LOST, METRICS_UNSOLVABLE, METRICS_STOPPED};
+
+    if (bot->metrics != NULL) {
+        bot_update_metrics(bot);
+        metrics_write_begin(bot->metrics);
+        bot->metrics->result = results[res];
+        metrics_write_end(bot->metrics);
+    }
+    return res;
+}
+
+static void bot_checkpoint(struct Bot* bot, struct ASPath* path, uint32_t next_i, enum GameState gs)
+{
+    /* Track move for checkpoints and stage one when it is due. Stopping
+     * stages a final checkpoint so the game can be resumed from there */
+    struct Checkpointer* cp = bot->ckpt;
+
+    checkpoint_track(cp, bot->game);
+
+    if (gs != GAME_NONE)
+        return;
+
+    if (*bot->is_stopped)
+        checkpoint_stage(cp, bot->game, path, next_i, bot->nmoves, bot->nplans, true);
+    else if (checkpoint_is_due(cp, bot_now_ns()))
+        checkpoint_stage(cp, bot->game, path, next_i, bot->nmoves, bot->nplans, false);
+}
+
+void bot_resume(struct Bot* bot, struct Checkpoint* ck)
+{
+    /* Continue pending path and counters of checkpointed game */
+    struct CheckpointHeader* hdr = ck->header;
+
+    memcpy(bot->planner.path.steps, ck->path, AS_PATH_BUFSIZE(hdr->path_len));
+    bot->planner.path.len = hdr->path_len;
+    bot->resume_i = hdr->path_i;
+    bot->is_resumed = hdr->path_i < hdr->path_len;
+
+    bot->nmoves = bot->nmoves_rate = hdr->nmoves;
+    bot->nplans = bot->nplans_rate = hdr->nplans;
+}
+
+enum GameState exec_path(struct Bot* bot, struct ASPath* path, uint32_t i0)
+{
+    /* Execute found path in snake game, starting at step i0 */
+    enum GameState gs = GAME_NONE;
+
+    for (uint32_t i=i0 ; i<path->len ; i++) {
+        enum ASDir dir = astar_path_get(path, i);
+
+        // on reject, take the safer step and let bot_run() plan again
+        bool is_rejected = false;
+        if (bot->use_artic && bot->game->snake.len < bot->planner.longest_len)
+            is_rejected = bot_artic_reject(bot, path, i, &dir);
+
+        // apply move, path directions map directly to snake directions
+        PROF_START(exec);
+        gs = game_next(bot->game, (enum Direction)dir);
+        PROF_STOP(PROF_EXEC, exec);
+
+        bot->nmoves++;
+        bot_publish(bot, gs != GAME_NONE);
+
+        if (bot->metrics != NULL)
+            bot_update_metrics(bot);
+
+        // rejected paths are not continued on resume
+        if (bot->ckpt != NULL)
+            bot_checkpoint(bot, path, is_rejected ? path->len : i+1, gs);
+
+        if (gs != GAME_NONE || *bot->is_stopped || is_rejected)
+            break;
+
+        sched_wait(&bot->sched, -1, NULL, NULL);
     }
     return gs;
 }
@@ -122,84 +397,239 @@ enum GameState exec_path(struct Game* game, struct Node* n_end, WINDOW* win, flo
 float get_perc_used(struct Astar* astar)
 {
     /* Calculate percentage of occupied nodes (that are marked as wall) */
-    int n_wall = 0;
-    for (int gi=0 ; gi<astar->xsize*astar->ysize ; gi++) {
-        if (astar->grid[gi].is_wall)
-            n_wall++;
-    }
+    uint32_t n_wall = astar_count_walls(astar);
     return (float)n_wall/(astar->xsize*astar->ysize)*100;
 }
 
-void bot_run(struct Bot* bot, WINDOW* field_win, WINDOW* bar_win)
-{
-    // FIXME All references to curses should be removed from this module,
-    //       Drawing should only happen by using callbacks
-    //
-    for (int i=0 ; ; i++) {
-        struct Astar astar;
-        struct Node grid[bot->xsize*bot->ysize];
-        struct Node* openset[bot->xsize*bot->ysize];
-        struct Node* closedset[bot->xsize*bot->ysize];
-
-        // NOTE shead/stail refers to the head/tail of linked list, not snake's head/tail
-        struct Seg* start = *bot->game->snake.stail;
-        Pos xstart = start->xpos;
-        Pos ystart = start->ypos;
-        Pos xend, yend;
-
-        enum ASPathType ptype;
-
-        // Use longest route as snake grows
-        // Start by using food as destination point
-        // Later Use tail as destination so snek won't lock himself up
-        if (bot->game->snake.len < 50) {
-            struct FoodItem* fend = *bot->game->food.fhead;
-            xend = fend->xpos;
-            yend = fend->ypos;
-            ptype = AS_SHORTEST;
-        }
-        else {
-            struct Seg* send = *bot->game->snake.shead;
-            xend = send->xpos;
-            yend = send->ypos;
-            ptype = AS_LONGEST;
-        }
+enum ASResult bot_plan(struct Bot* bot)
+{
+    /* Plan next path for game, result is stored in bot->planner.path */
+    enum ASResult res = planner_plan(&bot->planner, bot->game);
 
-        astar_init(&astar, grid, openset, closedset, bot->xsize, bot->ysize);
-        astar_set_points(&astar, xstart, ystart, xend, yend);
-
-        // disable drawing by uncommenting
-        //astar.draw_open_cb    = bot->draw_open_cb;
-        //astar.draw_closed_cb  = bot->draw_closed_cb;
-        //astar.draw_path_cb    = bot->draw_path_cb;
-        //astar.draw_wall_cb    = bot->draw_wall_cb;
-        //astar.draw_refresh_cb = bot->draw_refresh_cb;
-
-        // Set snake body as wall in astar
-        // Don't mark tail as wall or we will not be able to use it as a destination
-        struct Seg* seg = (*bot->game->snake.shead)->next;
-        while (seg != NULL) {
-            struct Node* n = get_node(astar.grid, seg->xpos, seg->ypos, bot->xsize);
-            n->is_wall = true;
-            seg = seg->next;
-        }
+    bot->os_len = bot->planner.astar.openset.len;
+    bot->cs_len = bot->planner.astar.closedset.len;
+    bot->perc_occ = get_perc_used(&bot->planner.astar);
+    return res;
+}
 
-        // solve path using algorithm
-        if (astar_find_path(&astar, ptype) == AS_UNSOLVED) {
-            show_msg("ASTAR UNSOLVABLE");
-            return;
+static enum ASResult bot_plan_dfield(struct Bot* bot)
+{
+    /* Plan a single step down the distance field, which is repaired
+     * for the last move instead of searching again */
+    enum ASDir dir;
+
+    PROF_START(search);
+    dfield_update(&bot->dfield, bot->game);
+    bool is_found = dfield_next(&bot->dfield, bot->game, &dir);
+    PROF_STOP(PROF_SEARCH, search);
+
+    if (!is_found)
+        return AS_UNSOLVED;
+
+    astar_path_set(&bot->planner.path, 0, dir);
+    bot->planner.path.len = 1;
+    return AS_SOLVED;
+}
+
+static void bot_dstar_reset(struct Bot* bot)
+{
+    /* Start a new search with current body as walls and all food as goals */
+    struct Game* game = bot->game;
+    struct Snake* snake = &game->snake;
+
+    memset(bot->ds_walls, 0, bot->xsize*bot->ysize);
+
+    // same walls as planner_plan() uses for shortest paths
+    struct Seg* seg = (snake->cur_len < snake->len) ? *snake->shead : (*snake->shead)->next;
+    for ( ; seg != NULL ; seg = seg->next)
+        bot->ds_walls[seg->ypos*bot->xsize + seg->xpos] = 1;
+
+    uint32_t ngoals = 0;
+    for (struct FoodItem* f = *game->food.fhead ; f != NULL ; f = f->next)
+        bot->ds_goals[ngoals++] = f->ypos*bot->xsize + f->xpos;
+
+    dstar_reset(&bot->dstar, planner_head_cell(game), bot->ds_walls, bot->ds_goals, ngoals);
+    bot->ds_nresets++;
+}
+
+static enum ASResult bot_plan_dstar(struct Bot* bot)
+{
+    /* Plan a single step, search is repaired for the last move */
+    struct Game* game = bot->game;
+    enum ASDir dir;
+
+    PROF_START(search);
+    if (!bot->ds_is_valid || bot->ds_score != game->score) {
+        bot_dstar_reset(bot);
+        bot->ds_is_valid = true;
+        bot->ds_score = game->score;
+    }
+    else {
+        uint32_t cells[PLANNER_NDELTAS];
+        bool is_wall[PLANNER_NDELTAS];
+        planner_wall_deltas(game, bot->ds_head, bot->ds_tail, cells, is_wall);
+        dstar_update_cells(&bot->dstar, cells, is_wall, PLANNER_NDELTAS);
+        dstar_move_start(&bot->dstar, planner_head_cell(game));
+    }
+    bot->ds_head = planner_head_cell(game);
+    bot->ds_tail = planner_tail_cell(game);
+
+    enum ASResult res = dstar_compute(&bot->dstar);
+    bot->ds_nplans++;
+    bot->ds_nexpanded += bot->dstar.nexpanded;
+    bot->cs_len = bot->dstar.nexpanded;
+    bot->os_len = bot->dstar.heap_len;
+    PROF_STOP(PROF_SEARCH, search);
+    PROF_COMMIT(PROF_EXPANDED);
+    PROF_COMMIT(PROF_OPEN_PEAK);
+
+    if (res != AS_SOLVED || !dstar_next(&bot->dstar, &dir))
+        return AS_UNSOLVED;
+
+    astar_path_set(&bot->planner.path, 0, dir);
+    bot->planner.path.len = 1;
+    return AS_SOLVED;
+}
+
+static void bot_dfield_init(struct Bot* bot)
+{
+    dfield_init(&bot->dfield, bot->xsize, bot->ysize);
+    bot->use_dfield = true;
+}
+
+static void bot_dfield_destroy(struct Bot* bot)
+{
+    dfield_destroy(&bot->dfield);
+}
+
+static void bot_dstar_init(struct Bot* bot)
+{
+    dstar_init(&bot->dstar, bot->xsize, bot->ysize);
+    bot->ds_walls = malloc(bot->xsize*bot->ysize);
+    bot->ds_goals = malloc(bot->game->maxfood * sizeof(uint32_t));
+    bot->ds_is_valid = false;
+    bot->ds_nplans = 0;
+    bot->ds_nresets = 0;
+    bot->ds_nexpanded = 0;
+    bot->use_dstar = true;
+}
+
+static void bot_dstar_destroy(struct Bot* bot)
+{
+    dstar_destroy(&bot->dstar);
+    free(bot->ds_walls);
+    free(bot->ds_goals);
+}
+
+static enum ASResult bot_plan_dfield_tail(struct Bot* bot)
+{
+    /* Distance field only targets food, long snakes chase their tail */
+    if (bot->game->snake.len < bot->planner.longest_len)
+        return bot_plan_dfield(bot);
+    return bot_plan(bot);
+}
+
+static enum ASResult bot_plan_dstar_tail(struct Bot* bot)
+{
+    /* D* Lite only targets food, long snakes chase their tail */
+    if (bot->game->snake.len < bot->planner.longest_len)
+        return bot_plan_dstar(bot);
+    return bot_plan(bot);
+}
+
+static const struct BotStrategy bot_strategies[] = {
+    {"astar",       "A* to nearest food, longest path to tail from length 50",
+                    NULL, NULL, &bot_plan, PLANNER_LONGEST_LEN, false, false},
+    {"astar-25",    "astar, longest path to tail from length 25",
+                    NULL, NULL, &bot_plan, 25, false, false},
+    {"astar-100",   "astar, longest path to tail from length 100",
+                    NULL, NULL, &bot_plan, 100, false, false},
+    {"astar-artic", "astar, avoiding moves that cut off the larger free space",
+                    NULL, NULL, &bot_plan, PLANNER_LONGEST_LEN, true, false},
+    {"dfield",      "cached BFS distance field to food, A* tail chase from length 50",
+                    &bot_dfield_init, &bot_dfield_destroy, &bot_plan_dfield_tail, PLANNER_LONGEST_LEN, false, true},
+    {"dstar",       "incremental D* Lite to food, A* tail chase from length 50",
+                    &bot_dstar_init, &bot_dstar_destroy, &bot_plan_dstar_tail, PLANNER_LONGEST_LEN, false, true},
+};
+
+uint32_t bot_strategy_count()
+{
+    return sizeof(bot_strategies)/sizeof(bot_strategies[0]);
+}
+
+const struct BotStrategy* bot_strategy_get(uint32_t i)
+{
+    return (i < bot_strategy_count()) ? &bot_strategies[i] : NULL;
+}
+
+const struct BotStrategy* bot_strategy_find(const char* name)
+{
+    for (uint32_t i=0 ; i<bot_strategy_count() ; i++) {
+        if (strcmp(bot_strategies[i].name, name) == 0)
+            return &bot_strategies[i];
+    }
+    return NULL;
+}
+
+static bool bot_is_idle(struct Bot* bot)
+{
+    /* Check if game went on for too long without scoring */
+    if (bot->game->score != bot->idle_score) {
+        bot->idle_score = bot->game->score;
+        bot->idle_nmoves = bot->nmoves;
+    }
+    return bot->max_idle_moves > 0 && bot->nmoves - bot->idle_nmoves > bot->max_idle_moves;
+}
+
+enum BotResult bot_run(struct Bot* bot)
+{
+    /* Plan and execute paths until game ends, no path can be found or
+     * state is stopped. Drawing only happens by using callbacks */
+    if (bot->metrics != NULL) {
+        metrics_write_begin(bot->metrics);
+        bot->metrics->xsize = bot->xsize;
+        bot->metrics->ysize = bot->ysize;
+        bot->metrics->result = METRICS_RUNNING;
+        metrics_write_end(bot->metrics);
+    }
+
+    while (!*bot->is_stopped) {
+        PROF_POLL();
+
+        // continue checkpointed path before planning again
+        if (bot->is_resumed) {
+            bot->is_resumed = false;
+            enum GameState gs = exec_path(bot, &bot->planner.path, bot->resume_i);
+            if (gs == GAME_WON)
+                return bot_finish_metrics(bot, BOT_WON);
+            else if (gs == GAME_LOST)
+                return bot_finish_metrics(bot, BOT_LOST);
+            continue;
         }
 
-        struct Node* n_end = get_node(astar.grid, xend, yend, bot->xsize);
-        exec_path(bot->game, n_end, field_win, bot->state->speed_ms);
+        uint64_t t_plan = (bot->metrics != NULL) ? bot_now_ns() : 0;
+
+        enum ASResult res = bot->strategy->plan(bot);
+
+        if (res == AS_SOLVED)
+            bot->nplans++;
+
+        if (bot->metrics != NULL)
+            bot_update_plan_metrics(bot, res, bot_now_ns() - t_plan);
+
+        if (res != AS_SOLVED)
+            return bot_finish_metrics(bot, BOT_UNSOLVABLE);
+
+        enum GameState gs = exec_path(bot, &bot->planner.path, 0);
+        PROF_COMMIT(PROF_MALLOCS);
 
-        float perc_occ = get_perc_used(&astar);
+        if (gs == GAME_WON)
+            return bot_finish_metrics(bot, BOT_WON);
+        else if (gs == GAME_LOST)
+            return bot_finish_metrics(bot, BOT_LOST);
 
-        char buf[256] = "";
-        sprintf(buf, "i: %d  snek_len: %d  score: %d, os_len: %d, cs_len: %d, occ: %.2f%%", i, bot->game->snake.len, bot->game->score, astar.openset.len, astar.closedset.len, perc_occ);
-        werase(bar_win);
-        draw_bar(bar_win, buf);
-        wrefresh(bar_win);
-        bot->draw_refresh_cb();
+        if (bot_is_idle(bot))
+            break;
     }
+    return bot_finish_metrics(bot, BOT_STOPPED);
 }
@@ -9,9 +9,51 @@
 
 #include "astar.h"
 #include "snake.h"
+#include "planner.h"
+#include "dfield.h"
+#include "artic.h"
+#include "metrics.h"
+#include "checkpoint.h"
 #include "state.h"
+#include "sched.h"
 
-#include "ui.h"
+#define BOT_STATUS_SIZE 256
+
+enum BotResult {
+    BOT_WON,
+    BOT_LOST,
+    BOT_UNSOLVABLE,
+    BOT_STOPPED
+};
+
+// default strategy, see bot_strategy_find()
+#define BOT_DEFAULT_STRATEGY "astar"
+
+struct Bot;
+
+// How the bot plans, everything else (executing paths, publishing,
+// metrics, checkpoints) is shared by all strategies
+struct BotStrategy {
+    const char* name;
+    const char* desc;
+
+    // optional, setup and free strategy state in bot
+    void(*init)(struct Bot* bot);
+    void(*destroy)(struct Bot* bot);
+
+    // plan next path into bot->planner.path
+    enum ASResult(*plan)(struct Bot* bot);
+
+    // snake length from which tail is chased instead of food
+    uint32_t longest_len;
+
+    // reject moves into cut cells that lead into the smaller region
+    bool use_artic;
+
+    // food is approached one planned step at a time, leaving cut cell
+    // checks no follow up step to judge a split by
+    bool is_single_step;
+};
 
 struct Bot {
     uint32_t xsize;
@@ -19,6 +61,79 @@ struct Bot {
 
     struct Game* game;
     struct State* state;
+    const struct BotStrategy* strategy;
+
+    // game stops when this is set, state->is_stopped unless games are
+    // played on their own state copy that shares a stop flag
+    bool* is_stopped;
+
+    // planner and its last planned path
+    struct Planner planner;
+
+    // distance field to food, only used when use_dfield is set
+    bool use_dfield;
+    struct DField dfield;
+
+    // incremental planner, only used when use_dstar is set. Search is
+    // reset when food changes, otherwise walls are updated from head and
+    // tail deltas since last move
+    bool use_dstar;
+    struct DStar dstar;
+    uint8_t* ds_walls;
+    uint32_t* ds_goals;
+    bool ds_is_valid;
+    Cost ds_score;
+    uint32_t ds_head;
+    uint32_t ds_tail;
+    uint64_t ds_nplans;
+    uint64_t ds_nresets;
+    uint64_t ds_nexpanded;
+
+    // cut cells of free space, used by strategy or with state->use_artic.
+    // Moves into a cut cell that lead into the smaller region are rejected
+    bool use_artic;
+    struct Artic artic;
+    uint64_t ar_nchecks;
+    uint64_t ar_nrejects;
+
+    // status line that is passed along with every published move
+    char status[BOT_STATUS_SIZE];
+
+    // paces moves at state->speed_ms
+    struct Sched sched;
+
+    // called after every state->frame_skip moves, but no more than
+    // state->fps times per second, to hand current game state to display
+    void(*publish_cb)(struct Game* game, char* status);
+    uint64_t t_publish;
+
+    // stats for status line, rates are updated every second
+    uint64_t nmoves;
+    uint64_t nplans;
+    uint64_t t_rate;
+    uint64_t nmoves_rate;
+    uint64_t nplans_rate;
+    float moves_per_sec;
+    float plans_per_sec;
+
+    // result of last plan
+    uint32_t os_len;
+    uint32_t cs_len;
+    float perc_occ;
+
+    // stop game after this many moves without scoring, 0 is no limit
+    uint64_t max_idle_moves;
+    uint64_t idle_nmoves;
+    Cost idle_score;
+
+    // live metrics page that is updated every move, NULL to disable
+    struct SnekMetrics* metrics;
+
+    // periodic checkpoints of game and pending path, NULL to disable.
+    // After bot_resume() the first path is continued at resume_i
+    struct Checkpointer* ckpt;
+    bool is_resumed;
+    uint32_t resume_i;
 
     // callbacks for drawing results
     void(*draw_open_cb)(Pos x, Pos y);
@@ -29,6 +144,14 @@ struct Bot {
 };
 
 void bot_init(struct Bot* bot, struct Game* game, struct State* state, uint32_t xsize, uint32_t ysize);
-void bot_run(struct Bot* bot, WINDOW* field_win, WINDOW* bar_win);
+void bot_init_strategy(struct Bot* bot, struct Game* game, struct State* state, const struct BotStrategy* strategy, uint32_t xsize, uint32_t ysize);
+void bot_destroy(struct Bot* bot);
+enum ASResult bot_plan(struct Bot* bot);
+enum BotResult bot_run(struct Bot* bot);
+void bot_resume(struct Bot* bot, struct Checkpoint* ck);
+
+uint32_t bot_strategy_count();
+const struct BotStrategy* bot_strategy_get(uint32_t i);
+const struct BotStrategy* bot_strategy_find(const char* name);
 
 #endif
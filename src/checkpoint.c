@@ -0,0 +1,374 @@
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "checkpoint.h"
+#include "log.h"
+
+static uint64_t checkpoint_now_ns()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec*1000000000 + t.tv_nsec;
+}
+
+static size_t checkpoint_size(struct CheckpointHeader* hdr)
+{
+    return sizeof(*hdr) + (size_t)hdr->cur_len*sizeof(uint32_t)
+                        + (size_t)hdr->nfood*sizeof(uint32_t)
+                        + AS_PATH_BUFSIZE(hdr->path_len);
+}
+
+static bool checkpoint_is_valid(struct Checkpoint* ck)
+{
+    /* Check that header and sections describe a game that fits its board,
+     * cells are used as indices when game is recreated */
+    struct CheckpointHeader* hdr = ck->header;
+    uint64_t size = (uint64_t)hdr->xsize*hdr->ysize;
+
+    // game always has food, and a zero xorshift state never leaves zero
+    if (hdr->xsize == 0 || hdr->ysize == 0 || hdr->cur_len > hdr->len || hdr->cur_len > size ||
+        hdr->nfood == 0 || hdr->nfood > hdr->maxfood || hdr->food_rng == 0 ||
+        hdr->path_len > size || hdr->path_i > hdr->path_len)
+        return false;
+
+    for (uint32_t i=0 ; i<hdr->cur_len ; i++) {
+        if (ck->body[i] >= size)
+            return false;
+    }
+    for (uint32_t i=0 ; i<hdr->nfood ; i++) {
+        if (ck->food[i] >= size)
+            return false;
+    }
+    return true;
+}
+
+static void checkpoint_push(struct Checkpointer* cp, uint32_t ci)
+{
+    uint64_t n = atomic_load_explicit(&cp->npushed, memory_order_relaxed);
+    cp->ring[n % cp->ring_size] = ci;
+    atomic_store_explicit(&cp->npushed, n+1, memory_order_release);
+}
+
+static bool checkpoint_write(struct Checkpointer* cp)
+{
+    /* Write staged checkpoint to tmp file and rename it over path */
+    struct CheckpointHeader* hdr = &cp->stage;
+    size_t size = checkpoint_size(hdr);
+
+    int fd = open(cp->tmp_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return false;
+
+    if (ftruncate(fd, size) < 0) {
+        close(fd);
+        return false;
+    }
+
+    uint8_t* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return false;
+
+    uint8_t* p = map;
+    memcpy(p, hdr, sizeof(*hdr));
+    p += sizeof(*hdr);
+
+    // body is copied from ring in at most two pieces
+    uint64_t first = cp->stage_npushed - hdr->cur_len;
+    uint32_t slot = first % cp->ring_size;
+    uint32_t n0 = (slot + hdr->cur_len > cp->ring_size) ? cp->ring_size - slot : hdr->cur_len;
+    memcpy(p, &cp->ring[slot], n0*sizeof(uint32_t));
+    memcpy(p + n0*sizeof(uint32_t), cp->ring, (hdr->cur_len - n0)*sizeof(uint32_t));
+    p += hdr->cur_len*sizeof(uint32_t);
+
+    memcpy(p, cp->stage_food, hdr->nfood*sizeof(uint32_t));
+    p += hdr->nfood*sizeof(uint32_t);
+    memcpy(p, cp->stage_path, AS_PATH_BUFSIZE(hdr->path_len));
+
+    // slot of first body cell is reused by push first+ring_size, the push
+    // that is in progress may be writing it already
+    atomic_thread_fence(memory_order_acquire);
+    bool is_valid = atomic_load_explicit(&cp->npushed, memory_order_relaxed) < first + cp->ring_size;
+
+    is_valid = is_valid && msync(map, size, MS_SYNC) == 0;
+    munmap(map, size);
+
+    if (!is_valid || rename(cp->tmp_path, cp->path) < 0) {
+        unlink(cp->tmp_path);
+        return false;
+    }
+    return true;
+}
+
+static void* checkpoint_thread(void* arg)
+{
+    /* Write checkpoints as they are staged, until stopped and nothing is
+     * left to write */
+    struct Checkpointer* cp = arg;
+
+    pthread_mutex_lock(&cp->lock);
+    while (1) {
+        while (!cp->is_staged && cp->is_running)
+            pthread_cond_wait(&cp->cond, &cp->lock);
+
+        if (!cp->is_staged)
+            break;
+
+        pthread_mutex_unlock(&cp->lock);
+        bool is_written = checkpoint_write(cp);
+        pthread_mutex_lock(&cp->lock);
+
+        if (is_written)
+            cp->nwritten++;
+        else
+            cp->nfailed++;
+
+        cp->is_staged = false;
+        pthread_cond_broadcast(&cp->cond);
+    }
+    pthread_mutex_unlock(&cp->lock);
+    return NULL;
+}
+
+bool checkpoint_init(struct Checkpointer* cp, const char* path, uint32_t interval_ms, struct Game* game)
+{
+    /* Setup checkpoints of game to path, body ring is filled from current
+     * snake so resumed games can be checkpointed too */
+    uint32_t size = game->xsize*game->ysize;
+
+    cp->path = strdup(path);
+    cp->tmp_path = malloc(strlen(path) + 5);
+    sprintf(cp->tmp_path, "%s.tmp", path);
+
+    cp->xsize = game->xsize;
+    cp->ysize = game->ysize;
+    cp->interval_ns = (uint64_t)interval_ms * 1000000;
+    cp->t_next = checkpoint_now_ns() + cp->interval_ns;
+
+    cp->ring_size = 2*size;
+    cp->ring = malloc(cp->ring_size * sizeof(uint32_t));
+    atomic_init(&cp->npushed, 0);
+
+    cp->stage_food = malloc(game->maxfood * sizeof(uint32_t));
+    cp->stage_path = malloc(AS_PATH_BUFSIZE(size));
+    cp->is_staged = false;
+    cp->is_running = false;
+
+    cp->nwritten = 0;
+    cp->ndropped = 0;
+    cp->nfailed = 0;
+    cp->nstaged = 0;
+    cp->stage_ns_max = 0;
+    cp->stage_ns_total = 0;
+
+    pthread_mutex_init(&cp->lock, NULL);
+    pthread_cond_init(&cp->cond, NULL);
+
+    // NOTE shead/stail refers to the head/tail of linked list, not snake's head/tail
+    for (struct Seg* seg = *game->snake.shead ; seg != NULL ; seg = seg->next)
+        checkpoint_push(cp, seg->ypos*cp->xsize + seg->xpos);
+
+    return cp->ring != NULL && cp->stage_food != NULL && cp->stage_path != NULL;
+}
+
+void checkpoint_destroy(struct Checkpointer* cp)
+{
+    pthread_mutex_destroy(&cp->lock);
+    pthread_cond_destroy(&cp->cond);
+    free(cp->path);
+    free(cp->tmp_path);
+    free(cp->ring);
+    free(cp->stage_food);
+    free(cp->stage_path);
+}
+
+bool checkpoint_start(struct Checkpointer* cp)
+{
+    cp->is_running = true;
+
+    if (pthread_create(&cp->thread, NULL, checkpoint_thread, cp) != 0) {
+        cp->is_running = false;
+        return false;
+    }
+    return true;
+}
+
+void checkpoint_stop(struct Checkpointer* cp)
+{
+    /* Stop and join writer thread, staged checkpoint is written first */
+    if (!cp->is_running)
+        return;
+
+    pthread_mutex_lock(&cp->lock);
+    cp->is_running = false;
+    pthread_cond_broadcast(&cp->cond);
+    pthread_mutex_unlock(&cp->lock);
+
+    pthread_join(cp->thread, NULL);
+}
+
+void checkpoint_track(struct Checkpointer* cp, struct Game* game)
+{
+    /* Mirror last game move in body ring, must be called after every move */
+    struct Seg* head = *game->snake.stail;
+    checkpoint_push(cp, head->ypos*cp->xsize + head->xpos);
+}
+
+bool checkpoint_is_due(struct Checkpointer* cp, uint64_t now)
+{
+    return now >= cp->t_next;
+}
+
+bool checkpoint_stage(struct Checkpointer* cp, struct Game* game, struct ASPath* path, uint32_t path_i,
+                      uint64_t nmoves, uint64_t nplans, bool is_forced)
+{
+    /* Hand game state to writer thread. When the writer is still busy the
+     * checkpoint is dropped, or waited for when forced */
+    uint64_t t_start = checkpoint_now_ns();
+    cp->t_next = t_start + cp->interval_ns;
+
+    if (is_forced) {
+        pthread_mutex_lock(&cp->lock);
+        while (cp->is_staged)
+            pthread_cond_wait(&cp->cond, &cp->lock);
+    }
+    else if (pthread_mutex_trylock(&cp->lock) != 0) {
+        cp->ndropped++;
+        return false;
+    }
+    else if (cp->is_staged) {
+        pthread_mutex_unlock(&cp->lock);
+        cp->ndropped++;
+        return false;
+    }
+
+    struct CheckpointHeader* hdr = &cp->stage;
+    memcpy(hdr->magic, CHECKPOINT_MAGIC, sizeof(hdr->magic));
+    hdr->version = CHECKPOINT_VERSION;
+    hdr->grow_fac = game->grow_fac;
+    hdr->maxfood = game->maxfood;
+    hdr->seed = game->seed;
+    hdr->xsize = game->xsize;
+    hdr->ysize = game->ysize;
+    hdr->food_rng = game->food.rng;
+    hdr->score = game->score;
+    hdr->len = game->snake.len;
+    hdr->cur_len = game->snake.cur_len;
+    hdr->nmoves = nmoves;
+    hdr->nplans = nplans;
+
+    hdr->nfood = 0;
+    for (struct FoodItem* f = *game->food.fhead ; f != NULL ; f = f->next)
+        cp->stage_food[hdr->nfood++] = f->ypos*cp->xsize + f->xpos;
+
+    hdr->path_len = (path != NULL) ? path->len : 0;
+    hdr->path_i = path_i;
+    if (path != NULL)
+        memcpy(cp->stage_path, path->steps, AS_PATH_BUFSIZE(path->len));
+
+    cp->stage_npushed = atomic_load_explicit(&cp->npushed, memory_order_relaxed);
+    cp->is_staged = true;
+    pthread_cond_broadcast(&cp->cond);
+    pthread_mutex_unlock(&cp->lock);
+
+    uint64_t dt = checkpoint_now_ns() - t_start;
+    cp->nstaged++;
+    cp->stage_ns_total += dt;
+    if (dt > cp->stage_ns_max)
+        cp->stage_ns_max = dt;
+    return true;
+}
+
+bool checkpoint_load(struct Checkpoint* ck, const char* path)
+{
+    /* Map checkpoint file for reading */
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(struct CheckpointHeader)) {
+        close(fd);
+        return false;
+    }
+
+    ck->size = st.st_size;
+    ck->map = mmap(NULL, ck->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (ck->map == MAP_FAILED)
+        return false;
+
+    ck->header = ck->map;
+    struct CheckpointHeader* hdr = ck->header;
+
+    if (memcmp(hdr->magic, CHECKPOINT_MAGIC, sizeof(hdr->magic)) != 0 || hdr->version != CHECKPOINT_VERSION ||
+        checkpoint_size(hdr) != ck->size || hdr->cur_len == 0) {
+        log_error("Not a checkpoint file: %s\n", path);
+        munmap(ck->map, ck->size);
+        return false;
+    }
+
+    uint8_t* p = (uint8_t*)ck->map + sizeof(*hdr);
+    ck->body = (uint32_t*)p;
+    ck->food = (uint32_t*)(p + (size_t)hdr->cur_len*sizeof(uint32_t));
+    ck->path = p + ((size_t)hdr->cur_len + hdr->nfood)*sizeof(uint32_t);
+
+    if (!checkpoint_is_valid(ck)) {
+        log_error("Corrupt checkpoint: %s\n", path);
+        munmap(ck->map, ck->size);
+        return false;
+    }
+    return true;
+}
+
+void checkpoint_unload(struct Checkpoint* ck)
+{
+    munmap(ck->map, ck->size);
+}
+
+void checkpoint_game_init(struct Checkpoint* ck, struct Game* game)
+{
+    /* Recreate game exactly as it was when checkpoint was staged */
+    struct CheckpointHeader* hdr = ck->header;
+
+    game->xsize = hdr->xsize;
+    game->ysize = hdr->ysize;
+    game->score = hdr->score;
+    game->maxfood = hdr->maxfood;
+    game->grow_fac = hdr->grow_fac;
+    game->seed = hdr->seed;
+    game->move_cb = NULL;
+
+    struct Snake* snake = &game->snake;
+    snake_init(snake, ck->body[0] % hdr->xsize, ck->body[0] / hdr->xsize);
+    snake->len = hdr->len;
+    snake->cur_len = hdr->cur_len;
+    for (uint32_t i=1 ; i<hdr->cur_len ; i++)
+        seg_init(snake->stail, ck->body[i] % hdr->xsize, ck->body[i] / hdr->xsize);
+
+    struct Food* food = &game->food;
+    food->rng = hdr->food_rng;
+    food->fhead = malloc(sizeof(struct FoodItem*));
+    food->ftail = malloc(sizeof(struct FoodItem*));
+    *food->fhead = NULL;
+    *food->ftail = NULL;
+
+    for (uint32_t i=0 ; i<hdr->nfood ; i++) {
+        struct FoodItem* f = malloc(sizeof(struct FoodItem));
+        f->xpos = ck->food[i] % hdr->xsize;
+        f->ypos = ck->food[i] / hdr->xsize;
+        f->prev = *food->ftail;
+        f->next = NULL;
+
+        if (*food->ftail != NULL)
+            (*food->ftail)->next = f;
+        else
+            *food->fhead = f;
+        *food->ftail = f;
+    }
+}
@@ -0,0 +1,116 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "snake.h"
+#include "astar.h"
+
+/* Checkpoints of long running bot games
+ *
+ * File layout, all fields in host byte order:
+ *   header:  game config, rng state, score and bot counters
+ *   body:    header.cur_len cell indices, tail first
+ *   food:    header.nfood cell indices in food list order
+ *   path:    pending bot path, packed like struct ASPath, bot continues
+ *            at step header.path_i
+ *
+ * Files are written by a background thread into a mapping of path.tmp that
+ * is renamed over path when complete, so path always holds a whole
+ * checkpoint. The game loop only copies food, the pending path and a few
+ * counters into a staging area. The body is read by the writer thread
+ * straight from a ring that mirrors the snake, ring slots that were
+ * overwritten while writing invalidate that checkpoint.
+ */
+
+#define CHECKPOINT_MAGIC "SNKC"
+#define CHECKPOINT_VERSION 1
+#define CHECKPOINT_DEFAULT_INTERVAL_MS 10000
+
+struct __attribute__((packed)) CheckpointHeader {
+    char magic[4];
+    uint8_t version;
+    uint8_t grow_fac;
+    uint16_t maxfood;
+    uint32_t seed;
+    uint32_t xsize;
+    uint32_t ysize;
+    uint32_t food_rng;
+    uint32_t score;
+    uint32_t len;
+    uint32_t cur_len;
+    uint32_t nfood;
+    uint32_t path_len;
+    uint32_t path_i;
+    uint64_t nmoves;
+    uint64_t nplans;
+};
+
+struct Checkpointer {
+    char* path;
+    char* tmp_path;
+    uint32_t xsize;
+    uint32_t ysize;
+
+    uint64_t interval_ns;
+    uint64_t t_next;
+
+    // cell indices of body, slot of push n is n % ring_size. Ring is twice
+    // the board size so the writer has at least a board worth of moves
+    // before staged slots are reused
+    uint32_t* ring;
+    uint32_t ring_size;
+    _Atomic uint64_t npushed;
+
+    // staged checkpoint, owned by writer while is_staged is set
+    struct CheckpointHeader stage;
+    uint32_t* stage_food;
+    uint8_t* stage_path;
+    uint64_t stage_npushed;
+    bool is_staged;
+
+    bool is_running;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+
+    // stats, dropped when writer was still busy, failed on io errors or
+    // when ring slots were overwritten
+    uint64_t nwritten;
+    uint64_t ndropped;
+    uint64_t nfailed;
+    uint64_t nstaged;
+    uint64_t stage_ns_max;
+    uint64_t stage_ns_total;
+};
+
+// loaded checkpoint, sections point into file mapping
+struct Checkpoint {
+    struct CheckpointHeader* header;
+    uint32_t* body;
+    uint32_t* food;
+    uint8_t* path;
+
+    void* map;
+    size_t size;
+};
+
+bool checkpoint_init(struct Checkpointer* cp, const char* path, uint32_t interval_ms, struct Game* game);
+void checkpoint_destroy(struct Checkpointer* cp);
+bool checkpoint_start(struct Checkpointer* cp);
+void checkpoint_stop(struct Checkpointer* cp);
+
+void checkpoint_track(struct Checkpointer* cp, struct Game* game);
+bool checkpoint_is_due(struct Checkpointer* cp, uint64_t now);
+bool checkpoint_stage(struct Checkpointer* cp, struct Game* game, struct ASPath* path, uint32_t path_i,
+                      uint64_t nmoves, uint64_t nplans, bool is_forced);
+
+bool checkpoint_load(struct Checkpoint* ck, const char* path);
+void checkpoint_unload(struct Checkpoint* ck);
+void checkpoint_game_init(struct Checkpoint* ck, struct Game* game);
+
+#endif
@@ -0,0 +1,330 @@
+#include "dfield.h"
+#include "planner.h"
+#include "prof.h"
+
+static uint32_t dfield_neighbours(struct DField* df, uint32_t ci, uint32_t* out)
+{
+    /* Get indices of neighbours within grid, N E S W order */
+    uint32_t x = ci % df->xsize;
+    uint32_t y = ci / df->xsize;
+    uint32_t n = 0;
+
+    if (y > 0)
+        out[n++] = ci - df->xsize;
+    if (x < df->xsize-1)
+        out[n++] = ci + 1;
+    if (y < df->ysize-1)
+        out[n++] = ci + df->xsize;
+    if (x > 0)
+        out[n++] = ci - 1;
+    return n;
+}
+
+static uint32_t dfield_cell(struct DField* df, Pos x, Pos y)
+{
+    return y*df->xsize + x;
+}
+
+void dfield_init(struct DField* df, uint32_t xsize, uint32_t ysize)
+{
+    uint32_t size = xsize*ysize;
+
+    df->xsize = xsize;
+    df->ysize = ysize;
+    df->dist = malloc(size * sizeof(uint32_t));
+    df->wall = malloc(size * sizeof(uint8_t));
+    df->queue = malloc(size * sizeof(uint32_t));
+    df->affected = malloc(size * sizeof(uint32_t));
+    df->mark = calloc(size, sizeof(uint8_t));
+    df->seeds = malloc(size * sizeof(struct DFSeed));
+    df->food = malloc(size * sizeof(uint32_t));
+    df->nfood = 0;
+
+    df->is_valid = false;
+    df->nupdates = 0;
+    df->nhits = 0;
+    df->nrebuilds = 0;
+    df->nrepaired = 0;
+}
+
+void dfield_destroy(struct DField* df)
+{
+    free(df->dist);
+    free(df->wall);
+    free(df->queue);
+    free(df->affected);
+    free(df->mark);
+    free(df->seeds);
+    free(df->food);
+}
+
+static uint32_t dfield_propagate(struct DField* df, uint32_t qh, uint32_t qt)
+{
+    /* Lower distances breadth first from cells in queue, returns amount
+     * of cells that were lowered */
+    uint32_t qstart = qt;
+    uint32_t nb[4];
+
+    while (qh < qt) {
+        uint32_t ci = df->queue[qh++];
+        uint32_t d = df->dist[ci] + 1;
+
+        for (uint32_t i=0, n=dfield_neighbours(df, ci, nb) ; i<n ; i++) {
+            if (!df->wall[nb[i]] && df->dist[nb[i]] > d) {
+                df->dist[nb[i]] = d;
+                df->queue[qt++] = nb[i];
+            }
+        }
+    }
+    return qt - qstart;
+}
+
+static void dfield_rebuild(struct DField* df, struct Game* game)
+{
+    /* Build field from scratch, BFS from all food at once */
+    struct Snake* snake = &game->snake;
+    uint32_t size = df->xsize*df->ysize;
+
+    for (uint32_t i=0 ; i<size ; i++) {
+        df->dist[i] = DFIELD_INF;
+        df->wall[i] = 0;
+    }
+
+    // NOTE shead/stail refers to the head/tail of linked list, not snake's head/tail
+    struct Seg* seg = (snake->cur_len < snake->len) ? *snake->shead : (*snake->shead)->next;
+    for ( ; seg != NULL ; seg = seg->next)
+        df->wall[dfield_cell(df, seg->xpos, seg->ypos)] = 1;
+
+    // food cells are sources, items on the same cell are queued once
+    uint32_t qt = 0;
+    df->nfood = 0;
+    for (struct FoodItem* f = *game->food.fhead ; f != NULL ; f = f->next) {
+        uint32_t ci = dfield_cell(df, f->xpos, f->ypos);
+        df->food[df->nfood++] = ci;
+        if (df->dist[ci] != 0) {
+            df->dist[ci] = 0;
+            df->queue[qt++] = ci;
+        }
+    }
+    dfield_propagate(df, 0, qt);
+
+    df->nrebuilds++;
+    df->is_valid = true;
+}
+
+static int dfield_seed_cmp(const void* a, const void* b)
+{
+    const struct DFSeed* sa = a;
+    const struct DFSeed* sb = b;
+    return (sa->d > sb->d) - (sa->d < sb->d);
+}
+
+static void dfield_add_wall(struct DField* df, uint32_t c)
+{
+    /* Cell became wall, invalidate cells whose shortest path depended on it
+     * level by level, then recompute them from the remaining cells */
+    uint32_t nb[4];
+
+    if (df->wall[c])
+        return;
+
+    df->wall[c] = 1;
+    uint32_t d0 = df->dist[c];
+    if (d0 == DFIELD_INF)
+        return;
+    df->dist[c] = DFIELD_INF;
+
+    // invalidate, FIFO keeps cells in order of distance so supports of a
+    // cell are already settled when it is checked
+    uint32_t qh = 0, qt = 0, naffected = 0;
+
+    for (uint32_t i=0, n=dfield_neighbours(df, c, nb) ; i<n ; i++) {
+        if (!df->wall[nb[i]] && df->dist[nb[i]] == d0+1 && !df->mark[nb[i]]) {
+            df->mark[nb[i]] = 1;
+            df->queue[qt++] = nb[i];
+        }
+    }
+
+    while (qh < qt) {
+        uint32_t ci = df->queue[qh++];
+        uint32_t d = df->dist[ci];
+        bool is_supported = false;
+        uint32_t n = dfield_neighbours(df, ci, nb);
+
+        for (uint32_t i=0 ; i<n ; i++) {
+            if (!df->wall[nb[i]] && df->dist[nb[i]] + 1 == d) {
+                is_supported = true;
+                break;
+            }
+        }
+        if (is_supported)
+            continue;
+
+        df->dist[ci] = DFIELD_INF;
+        df->affected[naffected++] = ci;
+
+        for (uint32_t i=0 ; i<n ; i++) {
+            if (!df->wall[nb[i]] && df->dist[nb[i]] == d+1 && !df->mark[nb[i]]) {
+                df->mark[nb[i]] = 1;
+                df->queue[qt++] = nb[i];
+            }
+        }
+    }
+
+    for (uint32_t i=0 ; i<qt ; i++)
+        df->mark[df->queue[i]] = 0;
+
+    if (naffected == 0)
+        return;
+
+    // seed invalidated cells from their settled neighbours
+    struct DFSeed* seeds = df->seeds;
+    uint32_t nseeds = 0;
+
+    for (uint32_t ai=0 ; ai<naffected ; ai++) {
+        uint32_t ci = df->affected[ai];
+        uint32_t best = DFIELD_INF;
+
+        for (uint32_t i=0, n=dfield_neighbours(df, ci, nb) ; i<n ; i++) {
+            if (!df->wall[nb[i]] && df->dist[nb[i]] < best)
+                best = df->dist[nb[i]];
+        }
+        if (best != DFIELD_INF)
+            seeds[nseeds++] = (struct DFSeed){ci, best+1};
+    }
+    qsort(seeds, nseeds, sizeof(struct DFSeed), &dfield_seed_cmp);
+
+    // merge sorted seeds with BFS queue, both are in order of distance
+    uint32_t si = 0;
+    qh = qt = 0;
+
+    while (si < nseeds || qh < qt) {
+        uint32_t ci;
+
+        if (si < nseeds && (qh == qt || seeds[si].d <= df->dist[df->queue[qh]])) {
+            ci = seeds[si].ci;
+            if (df->dist[ci] <= seeds[si].d) {
+                si++;
+                continue;
+            }
+            df->dist[ci] = seeds[si++].d;
+        }
+        else {
+            ci = df->queue[qh++];
+        }
+
+        uint32_t d = df->dist[ci] + 1;
+        for (uint32_t i=0, n=dfield_neighbours(df, ci, nb) ; i<n ; i++) {
+            if (!df->wall[nb[i]] && df->dist[nb[i]] > d) {
+                df->dist[nb[i]] = d;
+                df->queue[qt++] = nb[i];
+            }
+        }
+    }
+
+    df->nrepaired += naffected;
+}
+
+static void dfield_remove_wall(struct DField* df, uint32_t c)
+{
+    /* Cell became open, distances can only go down from here */
+    uint32_t nb[4];
+
+    if (!df->wall[c])
+        return;
+
+    df->wall[c] = 0;
+    uint32_t best = DFIELD_INF;
+
+    for (uint32_t i=0, n=dfield_neighbours(df, c, nb) ; i<n ; i++) {
+        if (!df->wall[nb[i]] && df->dist[nb[i]] < best)
+            best = df->dist[nb[i]];
+    }
+    if (best == DFIELD_INF)
+        return;
+
+    df->dist[c] = best + 1;
+    df->queue[0] = c;
+    df->nrepaired += 1 + dfield_propagate(df, 0, 1);
+}
+
+static bool dfield_is_adjacent(struct DField* df, uint32_t a, uint32_t b)
+{
+    uint32_t nb[4];
+    for (uint32_t i=0, n=dfield_neighbours(df, a, nb) ; i<n ; i++) {
+        if (nb[i] == b)
+            return true;
+    }
+    return false;
+}
+
+static bool dfield_is_same_food(struct DField* df, struct Game* game)
+{
+    /* Check if food cells are the ones field was built for */
+    uint32_t i = 0;
+    for (struct FoodItem* f = *game->food.fhead ; f != NULL ; f = f->next) {
+        if (i == df->nfood || df->food[i++] != dfield_cell(df, f->xpos, f->ypos))
+            return false;
+    }
+    return i == df->nfood;
+}
+
+void dfield_update(struct DField* df, struct Game* game)
+{
+    /* Repair field for last move, or rebuild when any food changed or the
+     * snake didn't make a single step within the grid since last update */
+    uint32_t head = planner_head_cell(game);
+    uint32_t tail = planner_tail_cell(game);
+
+    df->nupdates++;
+
+    if (!df->is_valid || !dfield_is_same_food(df, game) || !dfield_is_adjacent(df, df->head, head)) {
+        dfield_rebuild(df, game);
+    }
+    else {
+        df->nhits++;
+
+        uint32_t cells[PLANNER_NDELTAS];
+        bool is_wall[PLANNER_NDELTAS];
+        planner_wall_deltas(game, df->head, df->tail, cells, is_wall);
+
+        // add walls before opening cells, both keep field exact
+        for (int i=0 ; i<PLANNER_NDELTAS ; i++) {
+            if (is_wall[i])
+                dfield_add_wall(df, cells[i]);
+        }
+        for (int i=0 ; i<PLANNER_NDELTAS ; i++) {
+            if (!is_wall[i])
+                dfield_remove_wall(df, cells[i]);
+        }
+    }
+
+    df->head = head;
+    df->tail = tail;
+}
+
+bool dfield_next(struct DField* df, struct Game* game, enum ASDir* dir)
+{
+    /* Step downhill from head */
+    const enum ASDir dirs[4] = {AS_DIR_N, AS_DIR_E, AS_DIR_S, AS_DIR_W};
+    struct Seg* head = *game->snake.stail;
+    uint32_t hx = head->xpos;
+    uint32_t hy = head->ypos;
+    uint32_t best = DFIELD_INF;
+
+    for (int i=0 ; i<4 ; i++) {
+        uint32_t x = hx + (dirs[i] == AS_DIR_E) - (dirs[i] == AS_DIR_W);
+        uint32_t y = hy + (dirs[i] == AS_DIR_S) - (dirs[i] == AS_DIR_N);
+
+        // unsigned, so wraps at 0 and is caught by upper bound
+        if (x >= df->xsize || y >= df->ysize)
+            continue;
+
+        uint32_t ci = y*df->xsize + x;
+        if (!df->wall[ci] && df->dist[ci] < best) {
+            best = df->dist[ci];
+            *dir = dirs[i];
+        }
+    }
+    return best != DFIELD_INF;
+}
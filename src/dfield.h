@@ -0,0 +1,70 @@
+#ifndef DFIELD_H
+#define DFIELD_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "astar.h"
+#include "snake.h"
+
+/* BFS distance field from the nearest food to every cell
+ *
+ * Field is a multi source BFS from all food cells. It is keyed on the set
+ * of food cells and kept in sync with the snake by repairing only around
+ * cells that changed: the new head becomes a wall and the freed tail
+ * becomes open. The snake then follows the gradient to the nearest food,
+ * one lookup of 4 neighbours per move.
+ *
+ * Walls are the same as for the shortest path planner: body without tail,
+ * unless the snake is growing. Edges don't wrap, like in A*.
+ */
+
+#define DFIELD_INF UINT32_MAX
+
+// repair seed, cell with its candidate distance
+struct DFSeed {
+    uint32_t ci;
+    uint32_t d;
+};
+
+struct DField {
+    uint32_t xsize;
+    uint32_t ysize;
+
+    // distance to food for every cell, DFIELD_INF if unreachable or wall
+    uint32_t* dist;
+    uint8_t* wall;
+
+    // scratch buffers for repairs, size cells each
+    uint32_t* queue;
+    uint32_t* affected;
+    uint8_t* mark;
+    struct DFSeed* seeds;
+
+    // field is built for these food cells, in food list order, and snake
+    // state
+    bool is_valid;
+    uint32_t* food;
+    uint32_t nfood;
+    uint32_t head;
+    uint32_t tail;
+
+    // stats, a hit is an update that didn't need a rebuild
+    uint64_t nupdates;
+    uint64_t nhits;
+    uint64_t nrebuilds;
+    uint64_t nrepaired;
+};
+
+void dfield_init(struct DField* df, uint32_t xsize, uint32_t ysize);
+void dfield_destroy(struct DField* df);
+
+// sync field with game, must be called after every move
+void dfield_update(struct DField* df, struct Game* game);
+
+// direction of neighbour of snake's head that is closest to food,
+// false if food can't be reached
+bool dfield_next(struct DField* df, struct Game* game, enum ASDir* dir);
+
+#endif
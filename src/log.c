@@ -0,0 +1,150 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "log.h"
+
+int log_level = LOG_DEFAULT_LEVEL;
+
+// A slot is free for writing at ring position pos when seq == pos and
+// ready for reading when seq == pos+1
+struct LogSlot {
+    _Atomic uint32_t seq;
+    uint8_t level;
+    char msg[LOG_MSG_SIZE];
+};
+
+static struct LogSlot log_ring[LOG_RING_SIZE];
+
+// next position to write to (many writers) and to read from (flush thread)
+static _Atomic uint32_t log_head;
+static uint32_t log_tail;
+
+static atomic_uint_fast64_t log_ndropped;
+
+static FILE* log_fp = NULL;
+static pthread_t log_thread;
+static atomic_bool log_is_running;
+
+static const char* log_prefixes[] = {"", "[ERROR] ", "[WARN] ", "[INFO] ", ""};
+
+static bool log_drain()
+{
+    /* Write all ready messages to file, returns true if anything was written */
+    bool is_written = false;
+
+    while (1) {
+        struct LogSlot* slot = &log_ring[log_tail & (LOG_RING_SIZE-1)];
+
+        if (atomic_load_explicit(&slot->seq, memory_order_acquire) != log_tail+1)
+            break;
+
+        fputs(log_prefixes[slot->level], log_fp);
+        fputs(slot->msg, log_fp);
+
+        // hand slot back to writers for next lap around the ring
+        atomic_store_explicit(&slot->seq, log_tail+LOG_RING_SIZE, memory_order_release);
+        log_tail++;
+        is_written = true;
+    }
+
+    if (is_written)
+        fflush(log_fp);
+
+    return is_written;
+}
+
+static void* log_flush_thread(void* arg)
+{
+    struct timespec ts = {0, LOG_FLUSH_INTERVAL_US*1000};
+
+    while (atomic_load(&log_is_running)) {
+        log_drain();
+        nanosleep(&ts, NULL);
+    }
+    log_drain();
+    return NULL;
+}
+
+bool log_init(char* path, int level)
+{
+    log_level = level;
+
+    for (uint32_t i=0 ; i<LOG_RING_SIZE ; i++)
+        atomic_init(&log_ring[i].seq, i);
+
+    atomic_init(&log_head, 0);
+    log_tail = 0;
+
+    if ((log_fp = fopen(path, "a")) == NULL)
+        return false;
+
+    atomic_store(&log_is_running, true);
+    if (pthread_create(&log_thread, NULL, log_flush_thread, NULL) != 0) {
+        atomic_store(&log_is_running, false);
+        fclose(log_fp);
+        log_fp = NULL;
+        return false;
+    }
+    return true;
+}
+
+void log_cleanup()
+{
+    /* Stop flush thread after writing all pending messages */
+    if (!atomic_load(&log_is_running))
+        return;
+
+    atomic_store(&log_is_running, false);
+    pthread_join(log_thread, NULL);
+
+    if (atomic_load(&log_ndropped) > 0)
+        fprintf(log_fp, "[WARN] dropped %lu log messages\n", (unsigned long)atomic_load(&log_ndropped));
+
+    fclose(log_fp);
+    log_fp = NULL;
+}
+
+uint64_t log_dropped()
+{
+    return atomic_load(&log_ndropped);
+}
+
+void log_write(int level, char* fmt, ...)
+{
+    /* Reserve a slot and format message into it, drop message if ring is full */
+    uint32_t pos = atomic_load_explicit(&log_head, memory_order_relaxed);
+    struct LogSlot* slot;
+
+    while (1) {
+        slot = &log_ring[pos & (LOG_RING_SIZE-1)];
+        int32_t diff = (int32_t)(atomic_load_explicit(&slot->seq, memory_order_acquire) - pos);
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&log_head, &pos, pos+1, memory_order_relaxed, memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0) {
+            atomic_fetch_add(&log_ndropped, 1);
+            return;
+        }
+        else {
+            pos = atomic_load_explicit(&log_head, memory_order_relaxed);
+        }
+    }
+
+    va_list ptr;
+    va_start(ptr, fmt);
+    int len = vsnprintf(slot->msg, LOG_MSG_SIZE, fmt, ptr);
+    va_end(ptr);
+
+    // mark truncated messages and keep them on their own line
+    if (len >= LOG_MSG_SIZE)
+        strcpy(&slot->msg[LOG_MSG_SIZE-5], "...\n");
+
+    slot->level = (level < LOG_DEBUG) ? level : LOG_DEBUG;
+    atomic_store_explicit(&slot->seq, pos+1, memory_order_release);
+}
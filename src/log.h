@@ -0,0 +1,62 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/* Asynchronous logger
+ *
+ * Messages are formatted into a fixed size slot of a lock-free ring
+ * buffer and written to file by a background thread. Writers never block,
+ * when the ring is full the message is dropped and counted.
+ *
+ * Levels above LOG_LEVEL are compiled out, levels above log_level are
+ * skipped at runtime before any formatting is done.
+ */
+
+#define LOG_NONE  0
+#define LOG_ERROR 1
+#define LOG_WARN  2
+#define LOG_INFO  3
+#define LOG_DEBUG 4
+
+// compile time level, override with: make LOG_LEVEL=0
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_DEBUG
+#endif
+
+#define LOG_DEFAULT_LEVEL LOG_INFO
+
+// must be a power of 2
+#define LOG_RING_SIZE 1024
+#define LOG_MSG_SIZE 256
+#define LOG_FLUSH_INTERVAL_US 20000
+
+#if LOG_LEVEL > LOG_NONE
+#define log_msg(lvl, ...)                                   \
+    do {                                                    \
+        if ((lvl) <= LOG_LEVEL && (lvl) <= log_level)       \
+            log_write((lvl), __VA_ARGS__);                  \
+    } while (0)
+#else
+// no reference to logger at all, eg: for libsnek
+// sizeof doesn't evaluate, but arguments are still type checked and used
+#define log_msg(lvl, ...) do { (void)sizeof(printf(__VA_ARGS__)); } while (0)
+#endif
+
+#define log_error(...) log_msg(LOG_ERROR, __VA_ARGS__)
+#define log_warn(...)  log_msg(LOG_WARN,  __VA_ARGS__)
+#define log_info(...)  log_msg(LOG_INFO,  __VA_ARGS__)
+#define debug(...)     log_msg(LOG_DEBUG, __VA_ARGS__)
+
+// runtime level
+extern int log_level;
+
+bool log_init(char* path, int level);
+void log_cleanup();
+void log_write(int level, char* fmt, ...) __attribute__((format(printf, 2, 3)));
+uint64_t log_dropped();
+
+#endif
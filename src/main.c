@@ -12,6 +12,16 @@
 #include "astar.h"
 #include "bot.h"
 #include "state.h"
+#include "render.h"
+#include "sched.h"
+#include "prof.h"
+#include "replay.h"
+#include "bench.h"
+#include "metrics.h"
+#include "checkpoint.h"
+#include "tourney.h"
+#include "tune.h"
+#include "trace.h"
 
 // grow n segments when eating food
 #define DEFAULT_GROW_AMOUNT 1
@@ -22,8 +32,11 @@
 // interval inbetween frames
 #define DEFAULT_SPEED_MS 100
 
+// board size when running headless without -W/-Y
+#define DEFAULT_HEADLESS_XSIZE 80
+#define DEFAULT_HEADLESS_YSIZE 24
+
 #define BAR_YSIZE 1
-#define SLEEP_CHECK_INTERVAL 50
 #define SNAKE_CHR "█"
 #define FOOD_CHR "█"
 
@@ -32,23 +45,74 @@ WINDOW* root_win;
 WINDOW* bar_win;
 WINDOW* field_win;
 
+// field is drawn into this buffer and flushed to field_win per row
+struct UIFrame field_frame;
+
+// frame that draw callbacks write into, this is a back buffer of the
+// renderer while the render thread is drawing
+struct UIFrame* draw_frame = &field_frame;
+
+// draws bot games in its own thread
+struct Renderer renderer;
+
+struct Recorder recorder;
+
+int snake_style;
+int food_style;
+int open_style;
+int closed_style;
+int path_style;
+int wall_style;
+
 int sigint_caught = 0;
 
+// state that is stopped on SIGINT
+struct State* sigint_state = NULL;
+
+// live metrics page bot publishes to, see -M
+struct SnekMetrics* metrics = NULL;
+
+// game checkpoints, see -k and -K
+struct Checkpointer checkpointer;
+bool is_checkpointing = false;
+struct Checkpoint resume;
+bool is_resuming = false;
+
+// tuned bot parameters per board size, see -O
+struct TuneTable tune_table;
+bool is_tuned = false;
+
+// bot searches are traced here, see -x
+struct Trace tracer;
+bool is_tracing = false;
+
 void on_sigint(int signum)
 {
     sigint_caught = 1;
+    if (sigint_state != NULL)
+        sigint_state->is_stopped = true;
+}
+
+void draw_game(struct Game* game)
+{
+    /* Draw game into draw_frame, scrolled to snake's head when board
+     * is bigger than frame */
+    struct Seg* head = *game->snake.stail;
+    ui_frame_clear(draw_frame);
+    ui_frame_center(draw_frame, head->xpos, head->ypos, game->xsize, game->ysize);
+    game_draw(game);
 }
 
 void draw_snake_cb(Pos x, Pos y)
 {
     /* callback to draw snake segment to display */
-    add_str(field_win, y, x, CRED, CDEFAULT, SNAKE_CHR);
+    ui_frame_set(draw_frame, x, y, snake_style);
 }
 
 void draw_food_cb(Pos x, Pos y)
 {
     /* callback to draw food item to display */
-    add_str(field_win, y, x, CBLUE, CDEFAULT, FOOD_CHR);
+    ui_frame_set(draw_frame, x, y, food_style);
 }
 
 void check_term_size(WINDOW* win, Pos xsize, Pos ysize)
@@ -126,33 +190,19 @@ void bar_draw(WINDOW* win, struct Game* game)
     add_str(win, 0, 0, CGREEN, CDEFAULT, "Score: %d", game->score);
 }
 
-bool non_blocking_sleep(int interval, bool(*callback)(void* arg), void* arg)
-{
-    /* Do a non blocking sleep that checks for user input */
-    struct timeval t_start, t_end;
-    gettimeofday(&t_start, NULL);
-
-    while (1) {
-        gettimeofday(&t_end, NULL);
-        if ((t_end.tv_sec*1000000 + t_end.tv_usec) - (t_start.tv_sec*1000000 + t_start.tv_usec) >= interval)
-            break;
-
-        // if input
-        if (callback(arg))
-            return true;
-
-        usleep(SLEEP_CHECK_INTERVAL);
-    }
-    return false;
-}
-
 void state_init(struct State* s)
 {
     s->v = DIR_E;
     s->is_stopped = false;
     s->is_paused = false;
 
-    getmaxyx(root_win, s->xsize, s->ysize);
+#ifdef FIXED_BOARD
+    s->xsize = XSIZE;
+    s->ysize = YSIZE;
+#else
+    s->xsize = 0;
+    s->ysize = 0;
+#endif
 }
 
 void show_msg(char* msg)
@@ -166,17 +216,30 @@ void show_msg(char* msg)
     nodelay(stdscr, TRUE);   // don't block
 }
 
-void play_game(struct State* s, struct Game* game)
+void record_move_cb(enum Direction v)
+{
+    /* callback to record every move that is made in game */
+    recorder_add(&recorder, v);
+}
+
+enum GameState play_game(struct State* s, struct Game* game)
 {
+    enum GameState gs = GAME_NONE;
+
+    struct Sched sched;
+    sched_init(&sched, s->speed_ms*1000);
+    uint64_t tick = 0;
+
     // main loop
     while (! s->is_stopped) {
         if (s->is_paused) {
             show_msg("PAUSED");
             s->is_paused = false;
+            sched_reset(&sched);
         }
         else {
             // go to next frame
-            enum GameState gs = game_next(game, s->v);
+            gs = game_next(game, s->v);
 
             if (gs == GAME_LOST) {
                 show_msg("YOU LOST BRAH!");
@@ -187,65 +250,537 @@ void play_game(struct State* s, struct Game* game)
                 s->is_stopped = true;
             }
 
-            ui_erase(field_win);
-            ui_erase(bar_win);
+            // only draw every n ticks when asked to
+            if (++tick % s->frame_skip == 0) {
+                ui_erase(bar_win);
 
-            game_draw(game);
-            bar_draw(bar_win, game);
+                draw_game(game);
+                bar_draw(bar_win, game);
 
-            ui_refresh(field_win);
-            ui_refresh(bar_win);
+                ui_frame_draw(field_win, &field_frame);
+                ui_refresh(field_win);
+                ui_refresh(bar_win);
+            }
         }
 
-        if (non_blocking_sleep(s->speed_ms*1000, &get_user_input, s)) {
-        }
+        // wake up on frame deadline or user input, input triggers the next
+        // frame right away so next interval starts counting from now
+        if (sched_wait(&sched, STDIN_FILENO, &get_user_input, s))
+            sched_reset(&sched);
     }
+    return gs;
 }
 
 void draw_open_cb(Pos x, Pos y)
 {
     /* callback to draw food item to display */
-    add_str(field_win, y, x, CGREEN, CDEFAULT, FOOD_CHR);
+    ui_frame_set(draw_frame, x, y, open_style);
 }
 
 void draw_closed_cb(Pos x, Pos y)
 {
     /* callback to draw food item to display */
-    add_str(field_win, y, x, CRED, CDEFAULT, FOOD_CHR);
+    ui_frame_set(draw_frame, x, y, closed_style);
 }
 
 void draw_path_cb(Pos x, Pos y)
 {
     /* callback to draw food item to display */
-    add_str(field_win, y, x, CWHITE, CDEFAULT, FOOD_CHR);
+    ui_frame_set(draw_frame, x, y, path_style);
 }
 
 void draw_wall_cb(Pos x, Pos y)
 {
     /* callback to draw food item to display */
-    add_str(field_win, y, x, CMAGENTA, CDEFAULT, "X");
+    ui_frame_set(draw_frame, x, y, wall_style);
 }
 
 void draw_refresh_cb()
 {
-    ui_refresh(field_win);
+    if (atomic_load(&renderer.is_running)) {
+        // keep viewport of published frame for next debug drawing
+        uint32_t xoff = draw_frame->xoff;
+        uint32_t yoff = draw_frame->yoff;
+
+        render_publish(&renderer);
+        draw_frame = &render_back(&renderer)->frame;
+        ui_frame_clear(draw_frame);
+        draw_frame->xoff = xoff;
+        draw_frame->yoff = yoff;
+    }
+    else {
+        ui_frame_draw(field_win, draw_frame);
+        ui_refresh(field_win);
+    }
+}
+
+void publish_cb(struct Game* game, char* status)
+{
+    /* callback to hand a snapshot of the game to the render thread */
+    PROF_START(draw);
+    struct RenderSnapshot* snap = render_back(&renderer);
+
+    draw_frame = &snap->frame;
+    draw_game(game);
+
+    strncpy(snap->status, status, RENDER_STATUS_SIZE-1);
+    snap->status[RENDER_STATUS_SIZE-1] = '\0';
+
+    render_publish(&renderer);
+    PROF_STOP(PROF_DRAW, draw);
+}
+
+enum GameState bot_result_state(enum BotResult res)
+{
+    if (res == BOT_LOST)
+        return GAME_LOST;
+    else if (res == BOT_WON)
+        return GAME_WON;
+    return GAME_NONE;
+}
+
+void attach_bot(struct Bot* bot)
+{
+    /* Hand metrics page, checkpoints, trace and resumed game to bot */
+    bot->metrics = metrics;
+
+    if (is_tracing)
+        bot->planner.trace = &tracer;
+
+    if (is_checkpointing)
+        bot->ckpt = &checkpointer;
+
+    if (is_resuming)
+        bot_resume(bot, &resume);
+}
+
+enum GameState play_headless(struct State* state, struct Game* game)
+{
+    /* Run bot at max speed without drawing anything */
+    const char* results[] = {"WON", "LOST", "UNSOLVABLE", "STOPPED"};
+
+    struct Bot bot;
+    bot_init(&bot, game, state, game->xsize, game->ysize);
+    attach_bot(&bot);
+
+    enum BotResult res = bot_run(&bot);
+
+    printf("bot: %s  strategy: %s  board: %ux%u  score: %u  len: %u  moves: %lu  plans: %lu\n",
+           results[res], bot.strategy->name, game->xsize, game->ysize, game->score, game->snake.len,
+           (unsigned long)bot.nmoves, (unsigned long)bot.nplans);
+
+    if (bot.use_dfield) {
+        struct DField* df = &bot.dfield;
+        uint64_t nupdates = (df->nupdates > 0) ? df->nupdates : 1;
+        uint64_t nhits = (df->nhits > 0) ? df->nhits : 1;
+        printf("dfield: updates: %lu  hits: %lu (%.1f%%)  rebuilds: %lu  repaired cells/hit: %.1f\n",
+               (unsigned long)df->nupdates, (unsigned long)df->nhits, 100.0 * df->nhits / nupdates,
+               (unsigned long)df->nrebuilds, (double)df->nrepaired / nhits);
+    }
+
+    if (bot.use_dstar) {
+        uint64_t nplans = (bot.ds_nplans > 0) ? bot.ds_nplans : 1;
+        printf("dstar: plans: %lu  resets: %lu  expanded: %lu  expanded/plan: %.1f\n",
+               (unsigned long)bot.ds_nplans, (unsigned long)bot.ds_nresets,
+               (unsigned long)bot.ds_nexpanded, (double)bot.ds_nexpanded / nplans);
+    }
+
+    if (is_checkpointing) {
+        struct Checkpointer* cp = &checkpointer;
+
+        // let writer finish last checkpoint
+        checkpoint_stop(cp);
+        uint64_t nstaged = (cp->nstaged > 0) ? cp->nstaged : 1;
+        printf("checkpoint: staged: %lu  written: %lu  dropped: %lu  failed: %lu  pause avg: %.1fus  max: %.1fus\n",
+               (unsigned long)cp->nstaged, (unsigned long)cp->nwritten, (unsigned long)cp->ndropped,
+               (unsigned long)cp->nfailed, cp->stage_ns_total / 1e3 / nstaged, cp->stage_ns_max / 1e3);
+    }
+
+    if (is_tracing) {
+        trace_flush(&tracer);
+        printf("trace: events: %lu  flushes: %lu  stalls: %lu  max stall: %.1fus\n",
+               (unsigned long)tracer.nevents, (unsigned long)tracer.nflushes,
+               (unsigned long)tracer.nstalls, tracer.stall_ns_max / 1e3);
+    }
+
+    if (bot.use_artic) {
+        printf("artic: checks: %lu  rejects: %lu\n",
+               (unsigned long)bot.ar_nchecks, (unsigned long)bot.ar_nrejects);
+    }
+
+    bot_destroy(&bot);
+    return bot_result_state(res);
 }
 
-void play_bot(struct State* state, struct Game* game)
+enum GameState play_bot(struct State* state, struct Game* game)
 {
     uint16_t xsize, ysize;
     getmaxyx(field_win, ysize, xsize);
 
     struct Bot bot;
-    bot_init(&bot, game, state, xsize, ysize);
+    bot_init(&bot, game, state, game->xsize, game->ysize);
 
     bot.draw_open_cb = &draw_open_cb;
     bot.draw_closed_cb = &draw_closed_cb;
     bot.draw_path_cb = &draw_path_cb;
     bot.draw_wall_cb = &draw_wall_cb;
     bot.draw_refresh_cb = &draw_refresh_cb;
+    bot.publish_cb = &publish_cb;
+    attach_bot(&bot);
+
+    render_init(&renderer, field_win, bar_win, xsize, ysize, state->fps);
+
+    if (!render_start(&renderer)) {
+        show_msg("FAILED TO START RENDER THREAD");
+        render_destroy(&renderer);
+        bot_destroy(&bot);
+        return GAME_NONE;
+    }
+
+    enum BotResult res = bot_run(&bot);
+
+    // curses is ours again after stopping render thread
+    render_stop(&renderer);
+    draw_frame = &field_frame;
+
+    if (res == BOT_UNSOLVABLE)
+        show_msg("ASTAR UNSOLVABLE");
+    else if (res == BOT_LOST)
+        show_msg("BOT LOST BRAH!");
+    else if (res == BOT_WON)
+        show_msg("BOT WON!");
+
+    render_destroy(&renderer);
+    bot_destroy(&bot);
+
+    return bot_result_state(res);
+}
+
+bool is_board_supported(uint32_t xsize, uint32_t ysize)
+{
+    /* Check if all cells of board can be addressed by Pos and Cost */
+    return (uint64_t)xsize*ysize <= (Cost)~0;
+}
+
+void board_size_error(uint32_t xsize, uint32_t ysize)
+{
+    fprintf(stderr, "Board of %ux%u cells doesn't fit in %lu bit costs, build with: make WIDE=1\n", xsize, ysize, sizeof(Cost)*8);
+}
+
+void game_size(struct State* s, uint32_t xdefault, uint32_t ydefault, uint32_t* xsize, uint32_t* ysize)
+{
+    /* Size of board that setup_game() creates, resumed games keep the size
+     * of the checkpoint */
+    if (is_resuming) {
+        *xsize = resume.header->xsize;
+        *ysize = resume.header->ysize;
+    }
+    else {
+        *xsize = (s->xsize > 0) ? s->xsize : xdefault;
+        *ysize = (s->ysize > 0) ? s->ysize : ydefault;
+    }
+}
+
+void setup_game(struct State* s, struct Game* game, uint32_t xsize, uint32_t ysize)
+{
+    if (is_resuming) {
+        checkpoint_game_init(&resume, game);
+    }
+    else {
+        game_init(game, xsize, ysize, s->max_food, s->seed);
+        game->grow_fac = s->grow_amount;
+    }
+
+    game->snake.draw_cb = &draw_snake_cb;
+    game->food.draw_cb = &draw_food_cb;
+
+    if (is_tuned) {
+        const struct TuneEntry* e = tune_find(&tune_table, game->xsize, game->ysize);
+        s->longest_len = e->longest_len;
+        s->use_artic = s->use_artic || e->use_artic;
+        log_info("tuned for %ux%u: longest_len=%u use_artic=%d\n", e->xsize, e->ysize, e->longest_len, e->use_artic);
+    }
+
+    if (s->checkpoint_path != NULL) {
+        if (checkpoint_init(&checkpointer, s->checkpoint_path, s->checkpoint_ms, game) && checkpoint_start(&checkpointer))
+            is_checkpointing = true;
+        else
+            log_error("Failed to start checkpoints: %s\n", s->checkpoint_path);
+    }
+
+    if (s->trace_path != NULL && s->mode == GM_BOT) {
+        if (trace_open(&tracer, s->trace_path, game->xsize, game->ysize))
+            is_tracing = true;
+        else
+            log_error("Failed to open trace: %s\n", s->trace_path);
+    }
+
+    if (s->record_path != NULL) {
+        if (recorder_open(&recorder, s->record_path, game))
+            game->move_cb = &record_move_cb;
+        else
+            log_error("Failed to open recording: %s\n", s->record_path);
+    }
+}
+
+void finish_game(struct Game* game, enum GameState gs)
+{
+    if (game->move_cb != NULL)
+        recorder_close(&recorder, game, gs);
+
+    if (is_checkpointing) {
+        checkpoint_stop(&checkpointer);
+        checkpoint_destroy(&checkpointer);
+    }
+
+    if (is_resuming)
+        checkpoint_unload(&resume);
+
+    if (is_tracing && !trace_close(&tracer))
+        log_error("Failed to write trace\n");
+
+    if (is_tuned)
+        tune_destroy(&tune_table);
+
+    game_destroy(game);
+}
+
+bool play_replay(struct State* state)
+{
+    /* Replay recorded game at max speed and verify result */
+    struct Replay replay;
+    struct Game game;
+
+    if (!replay_load(&replay, state->replay_path)) {
+        if (!state->is_headless)
+            ui_cleanup();
+        fprintf(stderr, "Failed to load replay: %s\n", state->replay_path);
+        return false;
+    }
+
+    replay_game_init(&replay, &game);
+    enum ReplayResult res;
+
+    if (state->is_headless) {
+        res = replay_run(&replay, &game, NULL);
+    }
+    else {
+        game.snake.draw_cb = &draw_snake_cb;
+        game.food.draw_cb = &draw_food_cb;
+
+        uint16_t xsize, ysize;
+        getmaxyx(field_win, ysize, xsize);
+        render_init(&renderer, field_win, bar_win, xsize, ysize, state->fps);
+
+        if (!render_start(&renderer)) {
+            show_msg("FAILED TO START RENDER THREAD");
+            render_destroy(&renderer);
+            ui_cleanup();
+            game_destroy(&game);
+            replay_destroy(&replay);
+            return false;
+        }
+
+        res = replay_run(&replay, &game, &publish_cb);
+
+        render_stop(&renderer);
+        render_destroy(&renderer);
+        draw_frame = &field_frame;
+
+        show_msg((res == REPLAY_OK) ? "REPLAY OK" : "REPLAY MISMATCH");
+        ui_cleanup();
+    }
+
+    printf("replay: %s  moves: %lu/%lu  score: %u/%u  len: %u/%u\n",
+           (res == REPLAY_OK) ? "OK" : "MISMATCH",
+           (unsigned long)replay.nmoves, (unsigned long)replay.trailer.nmoves,
+           replay.score, replay.trailer.score,
+           replay.len, replay.trailer.len);
+
+    game_destroy(&game);
+    replay_destroy(&replay);
+    return res == REPLAY_OK;
+}
+
+bool run_bench(struct State* state)
+{
+    /* Create corpus from headless bot games or benchmark planners on it */
+    struct Corpus corpus;
+
+    if (state->mode == GM_CORPUS) {
+        uint32_t xsize = (state->xsize > 0) ? state->xsize : BENCH_DEFAULT_XSIZE;
+        uint32_t ysize = (state->ysize > 0) ? state->ysize : BENCH_DEFAULT_YSIZE;
+        if (!is_board_supported(xsize, ysize)) {
+            board_size_error(xsize, ysize);
+            return false;
+        }
+        corpus_create(&corpus, state, xsize, ysize, state->ngames, state->interval);
+        printf("corpus: %u positions from %u games\n", corpus.npos, state->ngames);
+
+        bool is_ok = corpus_write(&corpus, state->corpus_path);
+        if (!is_ok)
+            fprintf(stderr, "Failed to write corpus: %s\n", state->corpus_path);
+
+        corpus_destroy(&corpus);
+        return is_ok;
+    }
+
+    if (!corpus_load(&corpus, state->corpus_path)) {
+        fprintf(stderr, "Failed to load corpus: %s\n", state->corpus_path);
+        return false;
+    }
+
+    bench_run(&corpus, stdout);
+    corpus_destroy(&corpus);
+    return true;
+}
+
+bool read_metrics(struct State* state)
+{
+    /* Print snapshot of live metrics page every interval, until bot is
+     * done, its process is gone or SIGINT */
+    struct SnekMetrics* m = metrics_open(state->metrics_path);
+    if (m == NULL) {
+        fprintf(stderr, "Failed to open metrics: %s\n", state->metrics_path);
+        return false;
+    }
+
+    struct timespec ts = {METRICS_READ_INTERVAL_MS / 1000, (METRICS_READ_INTERVAL_MS % 1000) * 1000000};
+    struct SnekMetrics snap;
+    bool is_gone = false;
+
+    while (!state->is_stopped) {
+        if (metrics_snapshot(m, &snap)) {
+            metrics_print(&snap, stdout);
+            if (snap.result != METRICS_RUNNING)
+                break;
+        }
+
+        // writer died, possibly halfway an update
+        if (metrics_is_gone(m)) {
+            is_gone = true;
+            break;
+        }
+        nanosleep(&ts, NULL);
+    }
+
+    if (is_gone)
+        fprintf(stderr, "Metrics writer is gone: pid %u\n", m->pid);
+
+    metrics_close(m);
+    return !is_gone;
+}
+
+static void trace_draw(struct State* state, struct Sched* sched, uint64_t nplans, uint64_t nexpanded)
+{
+    /* Show traced search so far and wait for next frame */
+    ui_erase(bar_win);
+    add_str(bar_win, 0, 0, CGREEN, CDEFAULT, "Plan: %lu  expanded: %lu", (unsigned long)nplans, (unsigned long)nexpanded);
+    ui_frame_draw(field_win, &field_frame);
+    ui_refresh(field_win);
+    ui_refresh(bar_win);
+
+    if (sched_wait(sched, STDIN_FILENO, &get_user_input, state))
+        sched_reset(sched);
+
+    if (state->is_paused) {
+        show_msg("PAUSED");
+        state->is_paused = false;
+        sched_reset(sched);
+    }
+}
+
+bool view_trace(struct State* state)
+{
+    /* Replay traced searches in terminal, every -t expansions is a frame.
+     * Headless, only the summary is printed */
+    struct TraceReader tr;
+    if (!trace_reader_open(&tr, state->trace_path)) {
+        if (!state->is_headless)
+            ui_cleanup();
+        fprintf(stderr, "Failed to open trace: %s\n", state->trace_path);
+        return false;
+    }
+
+    uint32_t xsize = tr.header.xsize;
+    uint32_t ysize = tr.header.ysize;
+    uint64_t nplans = 0;
+    uint64_t nsolved = 0;
+    uint64_t nopened = 0;
+    uint64_t nexpanded = 0;
+    uint64_t plan_expanded = 0;
+    uint64_t plan_expanded_max = 0;
+
+    struct Sched sched;
+    sched_init(&sched, state->speed_ms*1000);
+
+    struct TraceEvent ev;
+    while (!state->is_stopped && trace_read(&tr, &ev)) {
+        uint32_t x = ev.cell % xsize;
+        uint32_t y = ev.cell / xsize;
+        int style = -1;
+        bool is_frame = false;
+
+        switch (ev.type) {
+            case TRACE_PLAN:
+                nplans++;
+                plan_expanded = 0;
+                if (!state->is_headless) {
+                    ui_frame_clear(&field_frame);
+                    ui_frame_center(&field_frame, x, y, xsize, ysize);
+                }
+                style = path_style;
+                break;
+            case TRACE_GOAL:
+                style = food_style;
+                break;
+            case TRACE_WALL:
+                style = snake_style;
+                break;
+            case TRACE_OPEN:
+                nopened++;
+                style = open_style;
+                break;
+            case TRACE_CLOSE:
+                nexpanded++;
+                plan_expanded++;
+                style = closed_style;
+                is_frame = plan_expanded % state->frame_skip == 0;
+                break;
+            case TRACE_PATH:
+                style = path_style;
+                break;
+            case TRACE_DONE:
+                if (ev.g == AS_SOLVED)
+                    nsolved++;
+                if (plan_expanded > plan_expanded_max)
+                    plan_expanded_max = plan_expanded;
+                is_frame = true;
+                break;
+        }
+
+        if (state->is_headless)
+            continue;
 
-    bot_run(&bot, field_win, bar_win);
+        if (style >= 0)
+            ui_frame_set(&field_frame, x, y, style);
+        if (is_frame)
+            trace_draw(state, &sched, nplans, plan_expanded);
+    }
+
+    if (!state->is_headless) {
+        show_msg("TRACE DONE");
+        ui_cleanup();
+    }
+
+    uint64_t nplans_div = (nplans > 0) ? nplans : 1;
+    printf("trace: %s  board: %ux%u  plans: %lu  solved: %lu  opened: %lu  expanded: %lu  expanded/plan: %.1f  max: %lu\n",
+           state->trace_path, xsize, ysize, (unsigned long)nplans, (unsigned long)nsolved,
+           (unsigned long)nopened, (unsigned long)nexpanded, (double)nexpanded / nplans_div,
+           (unsigned long)plan_expanded_max);
+
+    trace_reader_close(&tr);
+    return true;
 }
 
 void print_usage()
@@ -254,9 +789,39 @@ void print_usage()
     printf("Optional args:\n");
     printf("    -H      play the game like a real human! (default)\n");
     printf("    -b      let the bot do the work!\n");
+    printf("    -d      bot follows cached BFS distance field to food instead of A*\n");
+    printf("    -L      bot replans incrementally with D* Lite instead of A*\n");
+    printf("    -P      bot strategy (default=%s), one of:\n", BOT_DEFAULT_STRATEGY);
+    for (uint32_t i=0 ; i<bot_strategy_count() ; i++)
+        printf("                %-12s %s\n", bot_strategy_get(i)->name, bot_strategy_get(i)->desc);
+    printf("    -a      bot avoids moves that cut off the larger part of free space, A* strategies only\n");
     printf("    -s      speed in miliseconds inbetween draws (default=100)\n");
+    printf("    -t      turbo, only draw every n game ticks (default=1)\n");
+    printf("    -F      max frames per second to draw (default=%d)\n", RENDER_DEFAULT_FPS);
     printf("    -g      grow amount (default=1)\n");
     printf("    -f      amount of food generated (default=1)\n");
+    printf("    -l      log level 0-4 (none/error/warn/info/debug, default=3)\n");
+    printf("    -S      random seed (default=time)\n");
+    printf("    -r      record game to file\n");
+    printf("    -R      replay game from file at max speed and verify result\n");
+    printf("    -W      board width (default=terminal width)\n");
+    printf("    -Y      board height (default=terminal height)\n");
+    printf("    -n      headless, bot or replay at max speed without drawing anything\n");
+    printf("    -c      create planner benchmark corpus file from headless bot games\n");
+    printf("    -N      amount of games to sample corpus from, or seeds to tune on (default=%d)\n", BENCH_DEFAULT_GAMES);
+    printf("    -i      sample corpus every n moves (default=%d)\n", BENCH_DEFAULT_INTERVAL);
+    printf("    -B      benchmark planners on corpus file\n");
+    printf("    -M      publish live bot metrics to shared file, eg: /dev/shm/snek.metrics\n");
+    printf("    -m      print live bot metrics from shared file every second\n");
+    printf("    -T      play all strategies headless on n seeds and compare them\n");
+    printf("    -j      tournament threads (default=one per cpu)\n");
+    printf("    -U      tune bot parameters per board size on -N seeds, write table to file\n");
+    printf("    -O      load tuned bot parameters from file, default strategy only\n");
+    printf("    -k      checkpoint bot game to file periodically and when stopped\n");
+    printf("    -K      resume bot game from checkpoint file\n");
+    printf("    -I      checkpoint interval in milliseconds (default=%d)\n", CHECKPOINT_DEFAULT_INTERVAL_MS);
+    printf("    -x      trace bot's A* searches to file\n");
+    printf("    -X      view A* trace from file, -s and -t set speed\n");
 }
 
 bool parse_args(struct State* state, int argc, char** argv)
@@ -265,10 +830,31 @@ bool parse_args(struct State* state, int argc, char** argv)
 
     state->mode = GM_USER;
     state->speed_ms = DEFAULT_SPEED_MS;
+    state->frame_skip = 1;
+    state->fps = RENDER_DEFAULT_FPS;
     state->grow_amount = DEFAULT_GROW_AMOUNT;
     state->max_food = DEFAULT_MAXFOOD;
+    state->log_level = LOG_DEFAULT_LEVEL;
+    state->seed = time(NULL);
+    state->record_path = NULL;
+    state->replay_path = NULL;
+    state->is_headless = false;
+    state->strategy = BOT_DEFAULT_STRATEGY;
+    state->nseeds = TOURNEY_DEFAULT_SEEDS;
+    state->nthreads = 0;
+    state->longest_len = 0;
+    state->tune_path = NULL;
+    state->use_artic = false;
+    state->corpus_path = NULL;
+    state->metrics_path = NULL;
+    state->checkpoint_path = NULL;
+    state->resume_path = NULL;
+    state->checkpoint_ms = CHECKPOINT_DEFAULT_INTERVAL_MS;
+    state->trace_path = NULL;
+    state->ngames = BENCH_DEFAULT_GAMES;
+    state->interval = BENCH_DEFAULT_INTERVAL;
 
-    while((option = getopt(argc, argv, "bHhs:g:f:")) != -1){ //get option from the getopt() method
+    while((option = getopt(argc, argv, "bHhdLas:t:F:g:f:l:S:r:R:nW:Y:c:N:i:B:M:m:k:K:I:P:T:j:U:O:x:X:")) != -1){ //get option from the getopt() method
         switch (option) {
             case 'b':
                 state->mode = GM_BOT;
@@ -279,12 +865,103 @@ bool parse_args(struct State* state, int argc, char** argv)
             case 's':
                 state->speed_ms = atoi(optarg);
                 break;
+            case 't':
+                state->frame_skip = (atoi(optarg) > 0) ? atoi(optarg) : 1;
+                break;
+            case 'F':
+                state->fps = atoi(optarg);
+                break;
             case 'f':
                 state->max_food = atoi(optarg);
                 break;
             case 'g':
                 state->grow_amount = atoi(optarg);
                 break;
+            case 'l':
+                state->log_level = atoi(optarg);
+                break;
+            case 'S':
+                state->seed = strtoul(optarg, NULL, 10);
+                break;
+            case 'r':
+                state->record_path = optarg;
+                break;
+            case 'R':
+                state->mode = GM_REPLAY;
+                state->replay_path = optarg;
+                break;
+            case 'n':
+                state->is_headless = true;
+                break;
+            case 'd':
+                state->strategy = "dfield";
+                break;
+            case 'L':
+                state->strategy = "dstar";
+                break;
+            case 'P':
+                state->strategy = optarg;
+                break;
+            case 'T':
+                state->mode = GM_TOURNEY;
+                state->nseeds = atoi(optarg);
+                break;
+            case 'j':
+                state->nthreads = atoi(optarg);
+                break;
+            case 'U':
+                state->mode = GM_TUNE;
+                state->tune_path = optarg;
+                break;
+            case 'O':
+                state->tune_path = optarg;
+                break;
+            case 'a':
+                state->use_artic = true;
+                break;
+            case 'W':
+                state->xsize = atoi(optarg);
+                break;
+            case 'Y':
+                state->ysize = atoi(optarg);
+                break;
+            case 'c':
+                state->mode = GM_CORPUS;
+                state->corpus_path = optarg;
+                break;
+            case 'N':
+                state->ngames = atoi(optarg);
+                break;
+            case 'i':
+                state->interval = atoi(optarg);
+                break;
+            case 'B':
+                state->mode = GM_BENCH;
+                state->corpus_path = optarg;
+                break;
+            case 'M':
+                state->metrics_path = optarg;
+                break;
+            case 'm':
+                state->mode = GM_METRICS;
+                state->metrics_path = optarg;
+                break;
+            case 'k':
+                state->checkpoint_path = optarg;
+                break;
+            case 'K':
+                state->resume_path = optarg;
+                break;
+            case 'I':
+                state->checkpoint_ms = atoi(optarg);
+                break;
+            case 'x':
+                state->trace_path = optarg;
+                break;
+            case 'X':
+                state->mode = GM_TRACE;
+                state->trace_path = optarg;
+                break;
             case 'h':
                 print_usage();
                 return false;
@@ -312,10 +989,145 @@ int main(int argc, char** argv)
 
     struct State s;
     state_init(&s);
+    sigint_state = &s;
 
     if (!parse_args(&s, argc, argv))
         return 1;
 
+    // boards with a default width or height are checked when their size is known
+    if (s.xsize > 0 && s.ysize > 0 && !is_board_supported(s.xsize, s.ysize)) {
+        board_size_error(s.xsize, s.ysize);
+        return 1;
+    }
+
+#ifdef FIXED_BOARD
+    if (s.xsize != XSIZE || s.ysize != YSIZE) {
+        fprintf(stderr, "Board size is fixed to %ux%u in this build\n", XSIZE, YSIZE);
+        return 1;
+    }
+#endif
+
+    if (!log_init(LOG_PATH, s.log_level))
+        fprintf(stderr, "Failed to open log: %s\n", LOG_PATH);
+
+    PROF_INIT();
+
+    if (s.mode == GM_CORPUS || s.mode == GM_BENCH) {
+        bool is_ok = run_bench(&s);
+        log_cleanup();
+        return is_ok ? 0 : 1;
+    }
+
+    if (bot_strategy_find(s.strategy) == NULL) {
+        fprintf(stderr, "Unknown strategy: %s\n", s.strategy);
+        log_cleanup();
+        return 1;
+    }
+
+    // tournaments play all strategies, there -a only applies to A* ones
+    if (s.mode == GM_BOT && s.use_artic && bot_strategy_find(s.strategy)->is_single_step) {
+        fprintf(stderr, "Strategy %s plans single steps, -a can't be used with it\n", s.strategy);
+        log_cleanup();
+        return 1;
+    }
+
+    if (s.mode == GM_TOURNEY) {
+        uint32_t xsize = (s.xsize > 0) ? s.xsize : TOURNEY_DEFAULT_XSIZE;
+        uint32_t ysize = (s.ysize > 0) ? s.ysize : TOURNEY_DEFAULT_YSIZE;
+        if (!is_board_supported(xsize, ysize)) {
+            board_size_error(xsize, ysize);
+            log_cleanup();
+            return 1;
+        }
+        bool is_ok = tourney_run(&s, xsize, ysize, s.nseeds, s.nthreads, stdout);
+        log_cleanup();
+        return is_ok ? 0 : 1;
+    }
+
+    if (s.mode == GM_TUNE) {
+        bool is_ok = tune_run(&s, s.tune_path, s.ngames, s.nthreads, stdout);
+        if (!is_ok)
+            fprintf(stderr, "Failed to tune: %s\n", s.tune_path);
+        log_cleanup();
+        return is_ok ? 0 : 1;
+    }
+
+    // tuned table describes default strategy
+    if (s.mode == GM_BOT && s.tune_path != NULL) {
+        if (strcmp(s.strategy, BOT_DEFAULT_STRATEGY) != 0) {
+            fprintf(stderr, "Tuned parameters only apply to strategy %s\n", BOT_DEFAULT_STRATEGY);
+            log_cleanup();
+            return 1;
+        }
+        if (!(is_tuned = tune_load(&tune_table, s.tune_path))) {
+            fprintf(stderr, "Failed to load tuned parameters: %s\n", s.tune_path);
+            log_cleanup();
+            return 1;
+        }
+    }
+
+    if (s.mode == GM_METRICS) {
+        bool is_ok = read_metrics(&s);
+        log_cleanup();
+        return is_ok ? 0 : 1;
+    }
+
+    if (s.metrics_path != NULL && (metrics = metrics_create(s.metrics_path)) == NULL) {
+        fprintf(stderr, "Failed to create metrics: %s\n", s.metrics_path);
+        log_cleanup();
+        return 1;
+    }
+
+    if (s.resume_path != NULL) {
+        if (s.mode != GM_BOT || s.record_path != NULL) {
+            fprintf(stderr, "Only bot games can be resumed, without recording\n");
+            log_cleanup();
+            return 1;
+        }
+        if (!checkpoint_load(&resume, s.resume_path)) {
+            fprintf(stderr, "Failed to load checkpoint: %s\n", s.resume_path);
+            log_cleanup();
+            return 1;
+        }
+        is_resuming = true;
+    }
+
+    if (s.mode == GM_TRACE && s.is_headless) {
+        bool is_ok = view_trace(&s);
+        log_cleanup();
+        return is_ok ? 0 : 1;
+    }
+
+    if (s.mode == GM_REPLAY && s.is_headless) {
+        bool is_ok = play_replay(&s);
+        log_cleanup();
+        return is_ok ? 0 : 1;
+    }
+
+    if (s.is_headless) {
+        if (s.mode != GM_BOT) {
+            fprintf(stderr, "Humans can't play headless, use -b\n");
+            log_cleanup();
+            return 1;
+        }
+
+        uint32_t game_xsize, game_ysize;
+        game_size(&s, DEFAULT_HEADLESS_XSIZE, DEFAULT_HEADLESS_YSIZE, &game_xsize, &game_ysize);
+        if (!is_board_supported(game_xsize, game_ysize)) {
+            board_size_error(game_xsize, game_ysize);
+            log_cleanup();
+            return 1;
+        }
+
+        struct Game game;
+        s.speed_ms = 0;
+        setup_game(&s, &game, game_xsize, game_ysize);
+        finish_game(&game, play_headless(&s, &game));
+
+        log_cleanup();
+        PROF_DUMP();
+        return 0;
+    }
 
     // setup ncurses windows
     ui_init();
@@ -332,20 +1144,53 @@ int main(int argc, char** argv)
     bar_win = derwin(root_win, BAR_YSIZE, xsize, 0, 0);
     field_win = derwin(root_win, field_ysize, xsize, BAR_YSIZE, 0);
 
+    ui_frame_init(&field_frame, xsize, field_ysize);
+    snake_style  = ui_style_add(SNAKE_CHR, CRED, CDEFAULT);
+    food_style   = ui_style_add(FOOD_CHR, CBLUE, CDEFAULT);
+    open_style   = ui_style_add(FOOD_CHR, CGREEN, CDEFAULT);
+    closed_style = ui_style_add(FOOD_CHR, CRED, CDEFAULT);
+    path_style   = ui_style_add(FOOD_CHR, CWHITE, CDEFAULT);
+    wall_style   = ui_style_add("X", CMAGENTA, CDEFAULT);
 
-    // setup snake structs
-    struct Game game;
+    if (s.mode == GM_TRACE) {
+        bool is_ok = view_trace(&s);
+        ui_frame_destroy(&field_frame);
+        log_cleanup();
+        return is_ok ? 0 : 1;
+    }
 
-    game_init(&game, xsize, field_ysize, s.max_food);
+    if (s.mode == GM_REPLAY) {
+        bool is_ok = play_replay(&s);
+        ui_frame_destroy(&field_frame);
+        log_cleanup();
+        return is_ok ? 0 : 1;
+    }
+
+    uint32_t game_xsize, game_ysize;
+    game_size(&s, xsize, field_ysize, &game_xsize, &game_ysize);
+    if (!is_board_supported(game_xsize, game_ysize)) {
+        ui_frame_destroy(&field_frame);
+        ui_cleanup();
+        board_size_error(game_xsize, game_ysize);
+        log_cleanup();
+        return 1;
+    }
 
-    game.grow_fac = s.grow_amount;
-    game.snake.draw_cb = &draw_snake_cb;
-    game.food.draw_cb = &draw_food_cb;
+    // setup snake structs
+    struct Game game;
+    setup_game(&s, &game, game_xsize, game_ysize);
 
+    enum GameState gs;
     if (s.mode == GM_USER)
-        play_game(&s, &game);
+        gs = play_game(&s, &game);
     else
-        play_bot(&s, &game);
+        gs = play_bot(&s, &game);
 
+    finish_game(&game, gs);
+
+    ui_frame_destroy(&field_frame);
     ui_cleanup();
+    log_cleanup();
+
+    PROF_DUMP();
 }
@@ -0,0 +1,112 @@
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "metrics.h"
+
+static struct SnekMetrics* metrics_map(const char* path, int flags, int prot)
+{
+    /* Map metrics page from file, file is sized when created */
+    int fd = open(path, flags, 0644);
+    if (fd < 0)
+        return NULL;
+
+    if ((flags & O_CREAT) && ftruncate(fd, sizeof(struct SnekMetrics)) < 0) {
+        close(fd);
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(struct SnekMetrics)) {
+        close(fd);
+        return NULL;
+    }
+
+    void* map = mmap(NULL, sizeof(struct SnekMetrics), prot, MAP_SHARED, fd, 0);
+    close(fd);
+    return (map == MAP_FAILED) ? NULL : map;
+}
+
+struct SnekMetrics* metrics_create(const char* path)
+{
+    /* Create metrics page for writing, NULL on error */
+    struct SnekMetrics* m = metrics_map(path, O_RDWR | O_CREAT | O_TRUNC, PROT_READ | PROT_WRITE);
+    if (m == NULL)
+        return NULL;
+
+    memset(m, 0, sizeof(*m));
+    memcpy(m->magic, METRICS_MAGIC, sizeof(m->magic));
+    m->version = METRICS_VERSION;
+    atomic_init(&m->seq, 0);
+    m->pid = getpid();
+    m->result = METRICS_RUNNING;
+    return m;
+}
+
+struct SnekMetrics* metrics_open(const char* path)
+{
+    /* Open existing metrics page read only, NULL on error or if file is
+     * not a metrics page */
+    struct SnekMetrics* m = metrics_map(path, O_RDONLY, PROT_READ);
+    if (m == NULL)
+        return NULL;
+
+    if (memcmp(m->magic, METRICS_MAGIC, sizeof(m->magic)) != 0 || m->version != METRICS_VERSION) {
+        metrics_close(m);
+        return NULL;
+    }
+    return m;
+}
+
+void metrics_close(struct SnekMetrics* m)
+{
+    munmap(m, sizeof(*m));
+}
+
+bool metrics_snapshot(const struct SnekMetrics* m, struct SnekMetrics* snap)
+{
+    /* Copy consistent snapshot of metrics page, false when every try
+     * raced with an update or the writer is stuck halfway one */
+    struct timespec ts = {0, METRICS_SNAPSHOT_WAIT_US * 1000};
+
+    for (uint32_t i=0 ; i<METRICS_SNAPSHOT_TRIES ; i++) {
+        uint64_t seq = atomic_load_explicit(&m->seq, memory_order_acquire);
+        if (!(seq & 1)) {
+            memcpy(snap, m, sizeof(*snap));
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&m->seq, memory_order_relaxed) == seq)
+                return true;
+        }
+        nanosleep(&ts, NULL);
+    }
+    return false;
+}
+
+bool metrics_is_gone(const struct SnekMetrics* m)
+{
+    /* Check if writer process doesn't exist anymore. A live writer can go
+     * without updates for long, eg: planning on a big board */
+    return kill(m->pid, 0) < 0 && errno == ESRCH;
+}
+
+void metrics_print(const struct SnekMetrics* snap, FILE* fp)
+{
+    /* Print snapshot as key=value pairs on one line */
+    const char* results[] = {"RUNNING", "WON", "LOST", "UNSOLVABLE", "STOPPED"};
+    const char* result = (snap->result <= METRICS_STOPPED) ? results[snap->result] : "?";
+
+    fprintf(fp, "pid=%u board=%ux%u result=%s score=%lu len=%lu moves=%lu plans=%lu failures=%lu "
+                "moves_per_sec=%.0f plans_per_sec=%.0f plan_us_last=%.1f plan_us_max=%.1f os_peak=%lu cs_peak=%lu\n",
+            snap->pid, snap->xsize, snap->ysize, result,
+            (unsigned long)snap->score, (unsigned long)snap->len, (unsigned long)snap->nmoves,
+            (unsigned long)snap->nplans, (unsigned long)snap->nfailures,
+            snap->moves_per_sec, snap->plans_per_sec,
+            snap->plan_ns_last / 1e3, snap->plan_ns_max / 1e3,
+            (unsigned long)snap->os_peak, (unsigned long)snap->cs_peak);
+    fflush(fp);
+}
@@ -0,0 +1,85 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdatomic.h>
+
+#define METRICS_MAGIC "SNKM"
+#define METRICS_VERSION 1
+
+// refresh interval of metrics reader
+#define METRICS_READ_INTERVAL_MS 1000
+
+// snapshot retries, and wait inbetween, before giving up on a page that
+// stays busy
+#define METRICS_SNAPSHOT_TRIES 100
+#define METRICS_SNAPSHOT_WAIT_US 100
+
+enum MetricsResult {
+    METRICS_RUNNING,
+    METRICS_WON,
+    METRICS_LOST,
+    METRICS_UNSOLVABLE,
+    METRICS_STOPPED
+};
+
+/* Live bot metrics in a shared file, eg: /dev/shm/snek.metrics
+ *
+ * Bot updates the page in place every tick, it never waits on readers.
+ * seq is odd while an update is writing, readers copy the page and retry
+ * when seq changed in the meantime. A writer that dies mid update leaves
+ * seq odd, so retries are bounded:
+ *
+ *     struct SnekMetrics snap;
+ *     if (metrics_snapshot(m, &snap))
+ *         metrics_print(&snap, stdout);
+ */
+struct SnekMetrics {
+    char magic[4];
+    uint32_t version;
+    _Atomic uint64_t seq;
+
+    uint32_t pid;
+    uint32_t xsize;
+    uint32_t ysize;
+    uint32_t result;    // enum MetricsResult
+
+    uint64_t t_update_ns;   // CLOCK_MONOTONIC
+    uint64_t score;
+    uint64_t len;
+    uint64_t nmoves;
+    uint64_t nplans;
+    uint64_t nfailures;     // plans that didn't find a path
+
+    double moves_per_sec;
+    double plans_per_sec;
+
+    // planner latency, and peak open/closed set sizes over all plans
+    uint64_t plan_ns_last;
+    uint64_t plan_ns_max;
+    uint64_t os_peak;
+    uint64_t cs_peak;
+};
+
+static inline void metrics_write_begin(struct SnekMetrics* m)
+{
+    atomic_fetch_add_explicit(&m->seq, 1, memory_order_acq_rel);
+}
+
+static inline void metrics_write_end(struct SnekMetrics* m)
+{
+    atomic_fetch_add_explicit(&m->seq, 1, memory_order_release);
+}
+
+struct SnekMetrics* metrics_create(const char* path);
+struct SnekMetrics* metrics_open(const char* path);
+void metrics_close(struct SnekMetrics* m);
+
+bool metrics_snapshot(const struct SnekMetrics* m, struct SnekMetrics* snap);
+bool metrics_is_gone(const struct SnekMetrics* m);
+void metrics_print(const struct SnekMetrics* snap, FILE* fp);
+
+#endif
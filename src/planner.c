@@ -0,0 +1,187 @@
+#include "planner.h"
+#include "prof.h"
+
+void planner_init(struct Planner* planner, uint32_t xsize, uint32_t ysize)
+{
+    planner->xsize = xsize;
+    planner->ysize = ysize;
+
+    uint32_t size = xsize*ysize;
+
+#ifdef FIXED_BOARD
+    if (xsize != XSIZE || ysize != YSIZE)
+        die("Board size doesn't match FIXED_BOARD size");
+
+    planner->bufs = malloc(sizeof(struct PlannerBufs));
+    if (planner->bufs == NULL)
+        die("Failed to allocate planner buffers");
+
+    planner->grid = planner->bufs->grid;
+    planner->openset = planner->bufs->openset;
+    planner->closedset = planner->bufs->closedset;
+    planner->path_buf = planner->bufs->path;
+#else
+    planner->grid = malloc(AS_GRID_SIZE(xsize, ysize) * sizeof(struct Node));
+    planner->openset = malloc(size * sizeof(struct Node*));
+    planner->closedset = malloc(size * sizeof(struct Node*));
+    planner->path_buf = malloc(AS_PATH_BUFSIZE(size));
+#endif
+
+    astar_path_init(&planner->path, planner->path_buf, size);
+
+    planner->goals = NULL;
+    planner->goals_size = 0;
+    planner->longest_len = PLANNER_LONGEST_LEN;
+    planner->trace = NULL;
+}
+
+void planner_destroy(struct Planner* planner)
+{
+#ifdef FIXED_BOARD
+    free(planner->bufs);
+#else
+    free(planner->grid);
+    free(planner->openset);
+    free(planner->closedset);
+    free(planner->path_buf);
+#endif
+    free(planner->goals);
+}
+
+static uint32_t planner_set_goals(struct Planner* planner, struct Game* game)
+{
+    /* Collect positions of all food items, returns amount */
+    uint32_t ngoals = 0;
+
+    for (struct FoodItem* f = *game->food.fhead ; f != NULL ; f = f->next) {
+        if (ngoals == planner->goals_size) {
+            planner->goals_size = (planner->goals_size > 0) ? planner->goals_size*2 : game->maxfood;
+            planner->goals = realloc(planner->goals, planner->goals_size * 2 * sizeof(Pos));
+        }
+        planner->goals[ngoals*2] = f->xpos;
+        planner->goals[ngoals*2+1] = f->ypos;
+        ngoals++;
+    }
+    return ngoals;
+}
+
+uint32_t planner_head_cell(struct Game* game)
+{
+    // NOTE shead/stail refers to the head/tail of linked list, not snake's head/tail
+    struct Seg* head = *game->snake.stail;
+    return head->ypos*game->xsize + head->xpos;
+}
+
+uint32_t planner_tail_cell(struct Game* game)
+{
+    struct Seg* tail = *game->snake.shead;
+    return tail->ypos*game->xsize + tail->xpos;
+}
+
+void planner_wall_deltas(struct Game* game, uint32_t head0, uint32_t tail0, uint32_t* cells, bool* is_wall)
+{
+    /* Get the PLANNER_NDELTAS cells that may have changed wall state after
+     * a single move from head0/tail0, and whether they are walls now.
+     * Walls are the same as planner_plan() uses for shortest paths */
+    struct Snake* snake = &game->snake;
+    uint32_t head = planner_head_cell(game);
+    uint32_t tail = planner_tail_cell(game);
+    bool is_growing = snake->cur_len < snake->len;
+
+    cells[0] = head;
+    cells[1] = tail;
+    cells[2] = head0;
+    cells[3] = tail0;
+
+    for (int i=0 ; i<PLANNER_NDELTAS ; i++) {
+        uint32_t ci = cells[i];
+        bool is_body = ci == head || ci == tail || (ci == head0 && snake->cur_len > 1);
+        is_wall[i] = is_body && !(ci == tail && !is_growing);
+    }
+}
+
+static void planner_trace_done(struct Planner* planner, enum ASResult res)
+{
+    /* Record solved path back from end node, and result of search */
+    struct Astar* astar = &planner->astar;
+
+    if (res == AS_SOLVED) {
+        struct Node* n = get_node(astar->grid, astar->x1, astar->y1, planner->xsize);
+        for ( ; n != NULL ; n = n->parent)
+            trace_add(planner->trace, TRACE_PATH, pos2i(n->x, n->y, planner->xsize), n->g, 0);
+    }
+    trace_add(planner->trace, TRACE_DONE, pos2i(astar->x1, astar->y1, planner->xsize), res, 0);
+}
+
+enum ASResult planner_plan(struct Planner* planner, struct Game* game)
+{
+    /* Find path from snake's head to its destination and store it in planner->path */
+    struct Astar* astar = &planner->astar;
+
+    // NOTE shead/stail refers to the head/tail of linked list, not snake's head/tail
+    struct Seg* start = *game->snake.stail;
+    Pos xstart = start->xpos;
+    Pos ystart = start->ypos;
+
+    // Use longest route as snake grows
+    // Start by using nearest food as destination point
+    // Later Use tail as destination so snek won't lock himself up
+    enum ASPathType ptype = (game->snake.len < planner->longest_len) ? AS_SHORTEST : AS_LONGEST;
+
+    PROF_START(setup);
+    astar_init(astar, planner->grid, planner->openset, planner->closedset, planner->xsize, planner->ysize);
+    astar->trace = planner->trace;
+
+    if (planner->trace != NULL)
+        trace_add(planner->trace, TRACE_PLAN, pos2i(xstart, ystart, planner->xsize), ptype, 0);
+
+    if (ptype == AS_SHORTEST) {
+        uint32_t ngoals = planner_set_goals(planner, game);
+        astar_set_goals(astar, xstart, ystart, planner->goals, ngoals);
+
+        for (uint32_t i=0 ; planner->trace != NULL && i<ngoals ; i++)
+            trace_add(planner->trace, TRACE_GOAL, pos2i(planner->goals[i*2], planner->goals[i*2+1], planner->xsize), 0, 0);
+    }
+    else {
+        struct Seg* send = *game->snake.shead;
+        astar_set_points(astar, xstart, ystart, send->xpos, send->ypos);
+
+        if (planner->trace != NULL)
+            trace_add(planner->trace, TRACE_GOAL, pos2i(send->xpos, send->ypos, planner->xsize), 0, 0);
+    }
+    PROF_STOP(PROF_SETUP, setup);
+
+    PROF_START(walls);
+
+    // Set snake body as wall in astar
+    // Don't mark tail as wall or we will not be able to use it as a destination,
+    // unless snake is still growing and the tail won't move out of the way
+    struct Seg* seg = (*game->snake.shead)->next;
+    if (game->snake.cur_len < game->snake.len && ptype == AS_SHORTEST)
+        seg = *game->snake.shead;
+    while (seg != NULL) {
+        struct Node* n = get_node(astar->grid, seg->xpos, seg->ypos, planner->xsize);
+        n->is_wall = true;
+        if (planner->trace != NULL)
+            trace_add(planner->trace, TRACE_WALL, pos2i(seg->xpos, seg->ypos, planner->xsize), 0, 0);
+        seg = seg->next;
+    }
+    PROF_STOP(PROF_WALLS, walls);
+
+    // solve path using algorithm
+    PROF_START(search);
+    enum ASResult res = astar_find_path(astar, ptype);
+    PROF_STOP(PROF_SEARCH, search);
+
+    PROF_COMMIT(PROF_EXPANDED);
+    PROF_COMMIT(PROF_OPEN_PEAK);
+    PROF_COMMIT(PROF_SET_OPS);
+
+    if (res == AS_SOLVED)
+        res = astar_get_path(astar, &planner->path);
+
+    if (planner->trace != NULL)
+        planner_trace_done(planner, res);
+
+    return res;
+}
@@ -0,0 +1,68 @@
+#ifndef PLANNER_H
+#define PLANNER_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "astar.h"
+#include "snake.h"
+
+// Use longest path to tail instead of shortest path to food
+// once snake is this long so it won't lock itself up
+#define PLANNER_LONGEST_LEN 50
+
+#ifdef FIXED_BOARD
+// statically sized buffers of FIXED_BOARD builds. These are megabytes on
+// big boards, so they are allocated once per planner instead of living
+// in struct Planner, which is often on the stack
+struct PlannerBufs {
+    struct Node grid[AS_GRID_SIZE(XSIZE, YSIZE)];
+    struct Node* openset[XSIZE*YSIZE];
+    struct Node* closedset[XSIZE*YSIZE];
+    uint8_t path[AS_PATH_BUFSIZE(XSIZE*YSIZE)];
+};
+#endif
+
+// Planner memory and last planned path, all buffers are reused for every plan
+struct Planner {
+    uint32_t xsize;
+    uint32_t ysize;
+
+    // snake length from which longest path to tail is planned,
+    // PLANNER_LONGEST_LEN by default
+    uint32_t longest_len;
+
+    struct Astar astar;
+    struct Node* grid;
+    struct Node** openset;
+    struct Node** closedset;
+
+    // last planned path
+    struct ASPath path;
+    uint8_t* path_buf;
+
+    // food positions as x,y pairs, grows with amount of food
+    Pos* goals;
+    uint32_t goals_size;
+
+    // searches are recorded here when set, see trace.h
+    struct Trace* trace;
+
+#ifdef FIXED_BOARD
+    // pointers above point into these
+    struct PlannerBufs* bufs;
+#endif
+};
+
+// amount of cells returned by planner_wall_deltas()
+#define PLANNER_NDELTAS 4
+
+void planner_init(struct Planner* planner, uint32_t xsize, uint32_t ysize);
+void planner_destroy(struct Planner* planner);
+enum ASResult planner_plan(struct Planner* planner, struct Game* game);
+
+uint32_t planner_head_cell(struct Game* game);
+uint32_t planner_tail_cell(struct Game* game);
+void planner_wall_deltas(struct Game* game, uint32_t head0, uint32_t tail0, uint32_t* cells, bool* is_wall);
+
+#endif
@@ -0,0 +1,165 @@
+#include "prof.h"
+
+#ifdef PROF
+
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+
+struct ProfHist {
+    uint64_t count;
+    uint64_t min;
+    uint64_t max;
+    uint64_t sum;
+    uint64_t buckets[PROF_NBUCKETS];
+};
+
+static const char* prof_names[] = {
+    "setup", "walls", "search", "exec", "draw",
+    "expanded", "open_peak", "set_ops", "mallocs"
+};
+
+static const char* prof_units[] = {
+    "ns", "ns", "ns", "ns", "ns",
+    "nodes", "nodes", "ops", "calls"
+};
+
+_Thread_local uint64_t prof_counters[PROF_NIDS];
+
+// set on the profiled thread, histograms are only recorded there
+static _Thread_local bool prof_is_thread = false;
+
+static struct ProfHist prof_hists[PROF_NIDS];
+static volatile sig_atomic_t prof_dump_requested = 0;
+
+static void on_sigusr1(int signum)
+{
+    prof_dump_requested = 1;
+}
+
+void prof_init()
+{
+    memset(prof_hists, 0, sizeof(prof_hists));
+    memset(prof_counters, 0, sizeof(prof_counters));
+
+    for (int i=0 ; i<PROF_NIDS ; i++)
+        prof_hists[i].min = UINT64_MAX;
+
+    prof_is_thread = true;
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(struct sigaction));
+    action.sa_handler = on_sigusr1;
+    sigaction(SIGUSR1, &action, NULL);
+}
+
+uint64_t prof_now()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec*1000000000 + t.tv_nsec;
+}
+
+static uint32_t prof_bucket(uint64_t v)
+{
+    /* Values below 2^SUB_BITS get their own bucket, above that every
+     * power of 2 is split in 2^SUB_BITS linear sub buckets */
+    if (v < (1 << PROF_SUB_BITS))
+        return v;
+
+    uint32_t msb = 63 - __builtin_clzll(v);
+    uint32_t shift = msb - PROF_SUB_BITS;
+    return ((shift+1) << PROF_SUB_BITS) + ((v >> shift) & ((1 << PROF_SUB_BITS)-1));
+}
+
+static uint64_t prof_bucket_value(uint32_t b)
+{
+    /* Highest value that ends up in bucket b */
+    if (b < (1 << PROF_SUB_BITS))
+        return b;
+
+    uint32_t shift = (b >> PROF_SUB_BITS) - 1;
+    uint64_t sub = b & ((1 << PROF_SUB_BITS)-1);
+    return (((1 << PROF_SUB_BITS) + sub + 1) << shift) - 1;
+}
+
+void prof_record(enum ProfId id, uint64_t value)
+{
+    if (!prof_is_thread)
+        return;
+
+    struct ProfHist* h = &prof_hists[id];
+    h->count++;
+    h->sum += value;
+    if (value < h->min)
+        h->min = value;
+    if (value > h->max)
+        h->max = value;
+    h->buckets[prof_bucket(value)]++;
+}
+
+void prof_commit(enum ProfId id)
+{
+    /* Record accumulated counter and start counting from zero */
+    prof_record(id, prof_counters[id]);
+    prof_counters[id] = 0;
+}
+
+static uint64_t prof_percentile(struct ProfHist* h, double perc)
+{
+    uint64_t target = h->count * perc / 100;
+    uint64_t seen = 0;
+
+    for (uint32_t b=0 ; b<PROF_NBUCKETS ; b++) {
+        seen += h->buckets[b];
+        if (seen > target) {
+            uint64_t v = prof_bucket_value(b);
+            return (v < h->max) ? v : h->max;
+        }
+    }
+    return h->max;
+}
+
+bool prof_dump(char* path)
+{
+    /* Write histogram summaries as JSON, file is replaced atomically */
+    char tmp_path[256];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    FILE* fp = fopen(tmp_path, "w");
+    if (fp == NULL)
+        return false;
+
+    fprintf(fp, "{\n");
+    for (int i=0 ; i<PROF_NIDS ; i++) {
+        struct ProfHist* h = &prof_hists[i];
+        fprintf(fp, "  \"%s\": {\"unit\": \"%s\", \"count\": %lu, \"min\": %lu, \"mean\": %.1f, "
+                    "\"p50\": %lu, \"p90\": %lu, \"p99\": %lu, \"p999\": %lu, \"max\": %lu}%s\n",
+                prof_names[i], prof_units[i],
+                (unsigned long)h->count,
+                (unsigned long)((h->count > 0) ? h->min : 0),
+                (h->count > 0) ? (double)h->sum / h->count : 0.0,
+                (unsigned long)prof_percentile(h, 50),
+                (unsigned long)prof_percentile(h, 90),
+                (unsigned long)prof_percentile(h, 99),
+                (unsigned long)prof_percentile(h, 99.9),
+                (unsigned long)h->max,
+                (i < PROF_NIDS-1) ? "," : "");
+    }
+    fprintf(fp, "}\n");
+    fclose(fp);
+
+    return rename(tmp_path, path) == 0;
+}
+
+void prof_poll()
+{
+    /* Dump report if it was requested by SIGUSR1 */
+    if (prof_dump_requested) {
+        prof_dump_requested = 0;
+        prof_dump(PROF_PATH);
+    }
+}
+
+#endif
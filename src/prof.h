@@ -0,0 +1,77 @@
+#ifndef PROF_H
+#define PROF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Hot path instrumentation, build with: make PROF=1
+ *
+ * Phase timers measure on the monotonic clock, counters are accumulated
+ * during a plan and committed once per plan. Every timer and committed
+ * counter value is recorded in a log-linear (HDR style) histogram.
+ * Histograms are written as JSON to PROF_PATH at exit or on SIGUSR1.
+ *
+ * Only the thread that called prof_init() is profiled. Tournament workers
+ * play games concurrently, they count into their own counters and don't
+ * record anything.
+ *
+ * Without PROF defined all macros compile to nothing.
+ */
+
+#define PROF_PATH "./snake.prof.json"
+
+// histogram has 16 linear sub buckets per power of 2
+#define PROF_SUB_BITS 4
+#define PROF_NBUCKETS (64 << PROF_SUB_BITS)
+
+enum ProfId {
+    // phase timers in ns
+    PROF_SETUP,
+    PROF_WALLS,
+    PROF_SEARCH,
+    PROF_EXEC,
+    PROF_DRAW,
+
+    // counters per plan
+    PROF_EXPANDED,
+    PROF_OPEN_PEAK,
+    PROF_SET_OPS,
+    PROF_MALLOCS,
+
+    PROF_NIDS
+};
+
+#ifdef PROF
+
+extern _Thread_local uint64_t prof_counters[PROF_NIDS];
+
+void prof_init();
+uint64_t prof_now();
+void prof_record(enum ProfId id, uint64_t value);
+void prof_commit(enum ProfId id);
+void prof_poll();
+bool prof_dump(char* path);
+
+#define PROF_INIT()                 prof_init()
+#define PROF_START(t)               uint64_t prof_t_##t = prof_now()
+#define PROF_STOP(id, t)            prof_record((id), prof_now() - prof_t_##t)
+#define PROF_COUNT(id, n)           (prof_counters[(id)] += (n))
+#define PROF_MAX(id, v)             do { if ((v) > prof_counters[(id)]) prof_counters[(id)] = (v); } while (0)
+#define PROF_COMMIT(id)             prof_commit(id)
+#define PROF_POLL()                 prof_poll()
+#define PROF_DUMP()                 prof_dump(PROF_PATH)
+
+#else
+
+#define PROF_INIT()                 do {} while (0)
+#define PROF_START(t)               do {} while (0)
+#define PROF_STOP(id, t)            do {} while (0)
+#define PROF_COUNT(id, n)           do {} while (0)
+#define PROF_MAX(id, v)             do {} while (0)
+#define PROF_COMMIT(id)             do {} while (0)
+#define PROF_POLL()                 do {} while (0)
+#define PROF_DUMP()                 do {} while (0)
+
+#endif
+
+#endif
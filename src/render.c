@@ -0,0 +1,110 @@
+#include "render.h"
+
+void render_init(struct Renderer* r, WINDOW* field_win, WINDOW* bar_win, uint32_t xsize, uint32_t ysize, uint32_t fps)
+{
+    r->field_win = field_win;
+    r->bar_win = bar_win;
+
+    for (int i=0 ; i<RENDER_NBUFS ; i++) {
+        ui_frame_init(&r->bufs[i].frame, xsize, ysize);
+        r->bufs[i].status[0] = '\0';
+    }
+
+    r->back = 0;
+    atomic_init(&r->middle, 1);
+    r->front = 2;
+
+    sched_init(&r->sched, 1000000 / ((fps > 0) ? fps : RENDER_DEFAULT_FPS));
+
+    atomic_init(&r->is_running, false);
+    atomic_init(&r->npublished, 0);
+    r->ndrawn = 0;
+}
+
+void render_destroy(struct Renderer* r)
+{
+    for (int i=0 ; i<RENDER_NBUFS ; i++)
+        ui_frame_destroy(&r->bufs[i].frame);
+}
+
+struct RenderSnapshot* render_back(struct Renderer* r)
+{
+    /* Get buffer that simulation can write the next snapshot into */
+    return &r->bufs[r->back];
+}
+
+void render_publish(struct Renderer* r)
+{
+    /* Make back buffer available to render thread and take over the
+     * previous middle buffer, which is either already drawn or stale */
+    uint8_t old = atomic_exchange(&r->middle, r->back | RENDER_DIRTY);
+    r->back = old & ~RENDER_DIRTY;
+    atomic_fetch_add(&r->npublished, 1);
+}
+
+static bool render_acquire(struct Renderer* r)
+{
+    /* Swap front with middle if a new snapshot was published */
+    if (!(atomic_load(&r->middle) & RENDER_DIRTY))
+        return false;
+
+    uint8_t old = atomic_exchange(&r->middle, r->front);
+    r->front = old & ~RENDER_DIRTY;
+    return true;
+}
+
+static void render_draw(struct Renderer* r)
+{
+    struct RenderSnapshot* snap = &r->bufs[r->front];
+
+    werase(r->bar_win);
+    add_str(r->bar_win, 0, 0, CGREEN, CDEFAULT, "%s", snap->status);
+    ui_frame_draw(r->field_win, &snap->frame);
+
+    wnoutrefresh(r->bar_win);
+    wnoutrefresh(r->field_win);
+    doupdate();
+
+    r->ndrawn++;
+}
+
+static void* render_thread(void* arg)
+{
+    struct Renderer* r = arg;
+
+    sched_reset(&r->sched);
+
+    while (atomic_load(&r->is_running)) {
+        if (render_acquire(r))
+            render_draw(r);
+
+        sched_wait(&r->sched, -1, NULL, NULL);
+    }
+
+    // make sure last published snapshot is on screen
+    if (render_acquire(r))
+        render_draw(r);
+
+    return NULL;
+}
+
+bool render_start(struct Renderer* r)
+{
+    atomic_store(&r->is_running, true);
+
+    if (pthread_create(&r->thread, NULL, render_thread, r) != 0) {
+        atomic_store(&r->is_running, false);
+        return false;
+    }
+    return true;
+}
+
+void render_stop(struct Renderer* r)
+{
+    /* Stop and join render thread, curses can be used again after this */
+    if (!atomic_load(&r->is_running))
+        return;
+
+    atomic_store(&r->is_running, false);
+    pthread_join(r->thread, NULL);
+}
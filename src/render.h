@@ -0,0 +1,67 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "ui.h"
+#include "sched.h"
+
+/* Render thread that draws game snapshots at display rate.
+ *
+ * The simulation thread writes into the back buffer and publishes it,
+ * the render thread picks up the latest published buffer when it is
+ * time to draw. Buffers are swapped through a single atomic index so
+ * neither side ever blocks. When the simulation publishes faster than
+ * the display rate, intermediate snapshots are simply overwritten.
+ *
+ * NOTE curses is not thread safe, while the render thread is running
+ *      no other thread may call curses functions
+ */
+
+#define RENDER_NBUFS 3
+#define RENDER_DEFAULT_FPS 60
+#define RENDER_STATUS_SIZE 256
+
+// set in middle index when it holds a snapshot that wasn't drawn yet
+#define RENDER_DIRTY 0x80
+
+struct RenderSnapshot {
+    struct UIFrame frame;
+    char status[RENDER_STATUS_SIZE];
+};
+
+struct Renderer {
+    WINDOW* field_win;
+    WINDOW* bar_win;
+
+    struct RenderSnapshot bufs[RENDER_NBUFS];
+
+    // back is owned by simulation, front is owned by render thread,
+    // middle is exchanged between the two
+    uint8_t back;
+    _Atomic uint8_t middle;
+    uint8_t front;
+
+    struct Sched sched;
+
+    atomic_bool is_running;
+    pthread_t thread;
+
+    // stats, dropped = published - drawn
+    atomic_uint_fast64_t npublished;
+    uint64_t ndrawn;
+};
+
+void render_init(struct Renderer* r, WINDOW* field_win, WINDOW* bar_win, uint32_t xsize, uint32_t ysize, uint32_t fps);
+void render_destroy(struct Renderer* r);
+bool render_start(struct Renderer* r);
+void render_stop(struct Renderer* r);
+
+struct RenderSnapshot* render_back(struct Renderer* r);
+void render_publish(struct Renderer* r);
+
+#endif
@@ -0,0 +1,170 @@
+#include "replay.h"
+
+bool recorder_open(struct Recorder* rec, char* path, struct Game* game)
+{
+    /* Start recording game, must be called before the first move */
+    if ((rec->fp = fopen(path, "wb")) == NULL)
+        return false;
+
+    // we do our own buffering
+    setvbuf(rec->fp, NULL, _IONBF, 0);
+
+    struct ReplayHeader header;
+    memcpy(header.magic, REPLAY_MAGIC, sizeof(header.magic));
+    header.version = REPLAY_VERSION;
+    header.grow_fac = game->grow_fac;
+    header.maxfood = game->maxfood;
+    header.seed = game->seed;
+    header.xsize = game->xsize;
+    header.ysize = game->ysize;
+
+    if (fwrite(&header, sizeof(header), 1, rec->fp) != 1) {
+        fclose(rec->fp);
+        return false;
+    }
+
+    rec->nmoves = 0;
+    rec->nbytes = 0;
+    return true;
+}
+
+static void recorder_flush(struct Recorder* rec)
+{
+    fwrite(rec->buf, 1, rec->nbytes, rec->fp);
+    rec->nbytes = 0;
+}
+
+void recorder_add(struct Recorder* rec, enum Direction v)
+{
+    uint8_t shift = (rec->nmoves % 4) * 2;
+
+    if (shift == 0) {
+        if (rec->nbytes == REPLAY_BUFSIZE)
+            recorder_flush(rec);
+        rec->buf[rec->nbytes++] = 0;
+    }
+
+    rec->buf[rec->nbytes-1] |= (v & 0x3) << shift;
+    rec->nmoves++;
+}
+
+bool recorder_close(struct Recorder* rec, struct Game* game, enum GameState state)
+{
+    /* Write remaining moves and final result */
+    recorder_flush(rec);
+
+    struct ReplayTrailer trailer;
+    trailer.nmoves = rec->nmoves;
+    trailer.score = game->score;
+    trailer.len = game->snake.len;
+    trailer.state = state;
+
+    bool is_written = fwrite(&trailer, sizeof(trailer), 1, rec->fp) == 1;
+    return (fclose(rec->fp) == 0) && is_written;
+}
+
+bool replay_load(struct Replay* replay, char* path)
+{
+    /* Read recorded game, false when file is not a valid replay */
+    FILE* fp = fopen(path, "rb");
+    if (fp == NULL)
+        return false;
+
+    replay->moves = NULL;
+
+    if (fread(&replay->header, sizeof(replay->header), 1, fp) != 1)
+        goto on_err;
+
+    if (memcmp(replay->header.magic, REPLAY_MAGIC, sizeof(replay->header.magic)) != 0 || replay->header.version != REPLAY_VERSION) {
+        log_error("Not a replay file: %s\n", path);
+        goto on_err;
+    }
+
+    // board has to fit coordinates and cell indices, and leave room for food
+    struct ReplayHeader* hdr = &replay->header;
+    uint64_t ncells = (uint64_t)hdr->xsize*hdr->ysize;
+    if (hdr->xsize == 0 || hdr->ysize == 0 || hdr->xsize > (Pos)~0 || hdr->ysize > (Pos)~0 ||
+        ncells > UINT32_MAX || hdr->maxfood >= ncells) {
+        log_error("Invalid board in replay file: %s\n", path);
+        goto on_err;
+    }
+
+    if (fseek(fp, -(long)sizeof(replay->trailer), SEEK_END) != 0)
+        goto on_err;
+    if (fread(&replay->trailer, sizeof(replay->trailer), 1, fp) != 1)
+        goto on_err;
+
+    long size = (replay->trailer.nmoves + 3) / 4;
+    long expected = sizeof(replay->header) + size + sizeof(replay->trailer);
+    if (ftell(fp) != expected) {
+        log_error("Replay file is truncated: %s\n", path);
+        goto on_err;
+    }
+
+    replay->moves = malloc(size);
+    fseek(fp, sizeof(replay->header), SEEK_SET);
+    if (fread(replay->moves, 1, size, fp) != size)
+        goto on_err;
+
+    fclose(fp);
+    return true;
+
+on_err:
+    free(replay->moves);
+    replay->moves = NULL;
+    fclose(fp);
+    return false;
+}
+
+void replay_destroy(struct Replay* replay)
+{
+    free(replay->moves);
+}
+
+void replay_game_init(struct Replay* replay, struct Game* game)
+{
+    /* Recreate game as it was at the start of the recording */
+    struct ReplayHeader* h = &replay->header;
+
+    game_init(game, h->xsize, h->ysize, h->maxfood, h->seed);
+    game->grow_fac = h->grow_fac;
+}
+
+enum ReplayResult replay_run(struct Replay* replay, struct Game* game, void(*publish_cb)(struct Game* game, char* status))
+{
+    /* Re-execute recorded moves as fast as possible on game created by
+     * replay_game_init() and check if we end up with the recorded result.
+     * publish_cb may be NULL for no drawing */
+    char status[256] = "";
+
+    enum GameState gs = GAME_NONE;
+    uint64_t i;
+
+    for (i=0 ; i<replay->trailer.nmoves ; i++) {
+        enum Direction v = (replay->moves[i/4] >> ((i%4)*2)) & 0x3;
+        gs = game_next(game, v);
+
+        if (publish_cb != NULL) {
+            snprintf(status, sizeof(status), "REPLAY  move: %lu/%lu  score: %d", (unsigned long)i+1, (unsigned long)replay->trailer.nmoves, game->score);
+            publish_cb(game, status);
+        }
+
+        if (gs != GAME_NONE) {
+            i++;
+            break;
+        }
+    }
+
+    replay->nmoves = i;
+    replay->state = gs;
+    replay->score = game->score;
+    replay->len = game->snake.len;
+
+    if (replay->nmoves != replay->trailer.nmoves ||
+        replay->state != replay->trailer.state ||
+        replay->score != replay->trailer.score ||
+        replay->len != replay->trailer.len)
+        return REPLAY_MISMATCH;
+
+    return REPLAY_OK;
+}
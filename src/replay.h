@@ -0,0 +1,79 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "snake.h"
+
+/* Compact game recordings
+ *
+ * File layout, all fields in host byte order:
+ *   header:  game config needed to recreate the game from its seed
+ *   moves:   directions packed 2 bits per move, first move in lowest bits
+ *   trailer: amount of moves and final result to verify replay against
+ */
+
+#define REPLAY_MAGIC "SNKR"
+#define REPLAY_VERSION 1
+
+// moves are buffered and written in chunks of this many bytes
+#define REPLAY_BUFSIZE 65536
+
+struct __attribute__((packed)) ReplayHeader {
+    char magic[4];
+    uint8_t version;
+    uint8_t grow_fac;
+    uint16_t maxfood;
+    uint32_t seed;
+    uint32_t xsize;
+    uint32_t ysize;
+};
+
+struct __attribute__((packed)) ReplayTrailer {
+    uint64_t nmoves;
+    uint32_t score;
+    uint32_t len;
+    uint8_t state;
+};
+
+struct Recorder {
+    FILE* fp;
+    uint64_t nmoves;
+
+    uint32_t nbytes;
+    uint8_t buf[REPLAY_BUFSIZE];
+};
+
+enum ReplayResult {
+    REPLAY_OK,
+    REPLAY_MISMATCH,
+    REPLAY_ERROR
+};
+
+struct Replay {
+    struct ReplayHeader header;
+    struct ReplayTrailer trailer;
+
+    // packed moves
+    uint8_t* moves;
+
+    // result of replaying
+    uint64_t nmoves;
+    enum GameState state;
+    uint32_t score;
+    uint32_t len;
+};
+
+bool recorder_open(struct Recorder* rec, char* path, struct Game* game);
+void recorder_add(struct Recorder* rec, enum Direction v);
+bool recorder_close(struct Recorder* rec, struct Game* game, enum GameState state);
+
+bool replay_load(struct Replay* replay, char* path);
+void replay_destroy(struct Replay* replay);
+void replay_game_init(struct Replay* replay, struct Game* game);
+enum ReplayResult replay_run(struct Replay* replay, struct Game* game, void(*publish_cb)(struct Game* game, char* status));
+
+#endif
@@ -0,0 +1,98 @@
+#define _GNU_SOURCE     // ppoll()
+#include <poll.h>
+
+#include "sched.h"
+
+static void timespec_add_us(struct timespec* t, uint32_t us)
+{
+    t->tv_sec  += us / 1000000;
+    t->tv_nsec += (long)(us % 1000000) * 1000;
+    if (t->tv_nsec >= 1000000000) {
+        t->tv_nsec -= 1000000000;
+        t->tv_sec++;
+    }
+}
+
+static bool timespec_before(struct timespec* a, struct timespec* b)
+{
+    /* Check if a is earlier than b */
+    if (a->tv_sec != b->tv_sec)
+        return a->tv_sec < b->tv_sec;
+    return a->tv_nsec < b->tv_nsec;
+}
+
+static struct timespec timespec_diff(struct timespec* a, struct timespec* b)
+{
+    /* Calculate a-b, a should not be earlier than b */
+    struct timespec t = {a->tv_sec - b->tv_sec, a->tv_nsec - b->tv_nsec};
+    if (t.tv_nsec < 0) {
+        t.tv_nsec += 1000000000;
+        t.tv_sec--;
+    }
+    return t;
+}
+
+void sched_init(struct Sched* s, uint32_t interval_us)
+{
+    s->interval_us = interval_us;
+    sched_reset(s);
+}
+
+void sched_reset(struct Sched* s)
+{
+    /* Start counting next interval from now */
+    clock_gettime(CLOCK_MONOTONIC, &s->deadline);
+    timespec_add_us(&s->deadline, s->interval_us);
+}
+
+static void sched_advance(struct Sched* s, struct timespec* now)
+{
+    /* Move deadline one interval further. If we fell behind by more
+     * than an interval, don't try to catch up with a burst of frames */
+    timespec_add_us(&s->deadline, s->interval_us);
+
+    if (timespec_before(&s->deadline, now)) {
+        s->deadline = *now;
+        timespec_add_us(&s->deadline, s->interval_us);
+    }
+}
+
+bool sched_wait(struct Sched* s, int fd, bool(*callback)(void* arg), void* arg)
+{
+    /* Sleep until deadline. When fd is given, wake up when it is readable
+     * and pass control to callback. Returns true when callback reports
+     * handled input before deadline, deadline is not advanced in that case.
+     * Pass fd < 0 for a plain sleep. */
+    struct pollfd pfd = {.fd = fd, .events = POLLIN};
+    struct timespec now;
+
+    while (1) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        bool is_expired = !timespec_before(&now, &s->deadline);
+
+        if (fd >= 0) {
+            // when expired, still check for pending input without blocking
+            struct timespec timeout = {0, 0};
+            if (!is_expired)
+                timeout = timespec_diff(&s->deadline, &now);
+
+            if (ppoll(&pfd, 1, &timeout, NULL) > 0) {
+                if (callback(arg))
+                    return true;
+
+                // hung up or broken fd stays ready without any input, polling
+                // it again would spin until deadline
+                if (pfd.revents & (POLLHUP | POLLERR | POLLNVAL))
+                    fd = -1;
+            }
+        }
+        else if (!is_expired) {
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &s->deadline, NULL);
+        }
+
+        if (is_expired) {
+            sched_advance(s, &now);
+            return false;
+        }
+    }
+}
@@ -0,0 +1,23 @@
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+/* Frame scheduler that sleeps until an absolute deadline on the
+ * monotonic clock. Deadlines advance by a fixed interval so time spent
+ * in between waits doesn't accumulate as drift. Optionally wakes up
+ * early when a file descriptor becomes readable, eg: stdin.
+ */
+
+struct Sched {
+    struct timespec deadline;
+    uint32_t interval_us;
+};
+
+void sched_init(struct Sched* s, uint32_t interval_us);
+void sched_reset(struct Sched* s);
+bool sched_wait(struct Sched* s, int fd, bool(*callback)(void* arg), void* arg);
+
+#endif
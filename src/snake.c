@@ -1,8 +1,29 @@
 #include "snake.h"
+#include "prof.h"
 
-uint16_t get_rand(uint16_t lower, uint16_t upper)
+uint32_t rng_next(uint32_t* rng)
 {
-    return (rand() % (upper - lower + 1)) + lower;
+    /* xorshift32, state is owned by game so games are reproducible from seed */
+    uint32_t x = *rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *rng = x;
+}
+
+uint32_t rng_seed(uint32_t seed)
+{
+    /* Scramble seed into a valid (non zero) xorshift state */
+    uint32_t x = seed + 0x9e3779b9;
+    x = (x ^ (x >> 16)) * 0x85ebca6b;
+    x = (x ^ (x >> 13)) * 0xc2b2ae35;
+    x ^= x >> 16;
+    return (x != 0) ? x : 0x9e3779b9;
+}
+
+uint32_t get_rand(uint32_t* rng, uint32_t lower, uint32_t upper)
+{
+    return (rng_next(rng) % (upper - lower + 1)) + lower;
 }
 
 void get_newxy(Pos* x, Pos* y, uint32_t xsize, uint32_t ysize, enum Direction v)
@@ -35,16 +56,16 @@ void get_newxy(Pos* x, Pos* y, uint32_t xsize, uint32_t ysize, enum Direction v)
             (*x)--;
     }
     else {
-        debug("Failed to get coordinates: %d, %d\n", *x, *y);
+        log_error("Failed to get coordinates: %d, %d\n", *x, *y);
     }
 }
 
-void get_free_loc(struct FoodItem** ftail, struct Seg* stail, uint16_t xsize, uint16_t ysize, Pos* x, Pos* y)
+void get_free_loc(struct FoodItem** ftail, struct Seg* stail, uint32_t xsize, uint32_t ysize, uint32_t* rng, Pos* x, Pos* y)
 {
     /* Get random coordinates not occupied with snake body or fooditem */
     while (1) {
-        *x = get_rand(0, xsize-1);
-        *y = get_rand(0, ysize-1);
+        *x = get_rand(rng, 0, xsize-1);
+        *y = get_rand(rng, 0, ysize-1);
 
         // make sure we don't generate food where snake or food is
         if (seg_detect_col(stail, *x, *y, 0) == NULL) {
@@ -57,16 +78,41 @@ void get_free_loc(struct FoodItem** ftail, struct Seg* stail, uint16_t xsize, ui
 }
 
 
-void game_init(struct Game* game, uint32_t xsize, uint32_t ysize, uint16_t maxfood)
+void game_init(struct Game* game, uint32_t xsize, uint32_t ysize, uint16_t maxfood, uint32_t seed)
 {
     game->xsize = xsize;
     game->ysize = ysize;
     game->score = 0;
     game->maxfood = maxfood;
     game->grow_fac = SNAKE_DEFAULT_GROW_FACTOR;
+    game->seed = seed;
+    game->move_cb = NULL;
 
     snake_init(&game->snake, xsize/2, ysize/2);
-    food_init(&game->food, *game->snake.stail, xsize, ysize, maxfood);
+    food_init(&game->food, *game->snake.stail, xsize, ysize, maxfood, seed);
+}
+
+void game_destroy(struct Game* game)
+{
+    /* Free snake segments and food items */
+    struct Seg* seg = *game->snake.shead;
+    while (seg != NULL) {
+        struct Seg* next = seg->next;
+        free(seg);
+        seg = next;
+    }
+
+    struct FoodItem* f = *game->food.fhead;
+    while (f != NULL) {
+        struct FoodItem* next = f->next;
+        free(f);
+        f = next;
+    }
+
+    free(game->snake.shead);
+    free(game->snake.stail);
+    free(game->food.fhead);
+    free(game->food.ftail);
 }
 
 void game_draw(struct Game* game)
@@ -95,6 +141,9 @@ enum GameState game_next(struct Game* game, enum Direction v)
     struct Snake* snake = &game->snake;
     struct Food* food = &game->food;
 
+    if (game->move_cb != NULL)
+        game->move_cb(v);
+
     struct Seg* old = *snake->stail;
     Pos x = old->xpos;
     Pos y = old->ypos;
@@ -118,7 +167,7 @@ enum GameState game_next(struct Game* game, enum Direction v)
     if (f != NULL) {
         snake->len+=game->grow_fac;
         game->score++;
-        fooditem_init(food->ftail, *snake->stail, game->xsize, game->ysize);
+        fooditem_init(food->ftail, *snake->stail, game->xsize, game->ysize, &food->rng);
         fooditem_destroy(f, food->fhead, food->ftail);
     }
 
@@ -154,7 +203,7 @@ void snake_lremove(struct Seg** shead, uint16_t amount)
 
         // should be unreachable
         if ((*shead)->next == NULL) {
-            debug("Error removing head, no more segments\n");
+            log_error("Error removing head, no more segments\n");
             return;
         }
 
@@ -169,6 +218,7 @@ struct Seg* seg_init(struct Seg** stail, Pos xpos, Pos ypos)
 {
     /* Create new segment and replace stail */
     struct Seg* seg = malloc(sizeof(struct Seg));
+    PROF_COUNT(PROF_MALLOCS, 1);
     seg->xpos = xpos;
     seg->ypos = ypos;
     seg->next = NULL;
@@ -202,29 +252,30 @@ struct Seg* seg_detect_col(struct Seg* stail, Pos x, Pos y, uint16_t roffset)
 }
 
 
-void food_init(struct Food* food, struct Seg* stail, uint16_t xsize, uint16_t ysize, uint16_t maxfood)
+void food_init(struct Food* food, struct Seg* stail, uint32_t xsize, uint32_t ysize, uint16_t maxfood, uint32_t seed)
 {
-    // set random seed for food location generation
-    srand(time(NULL));
+    // seed random generator for food location generation
+    food->rng = rng_seed(seed);
 
     // init food linked list
     food->fhead = malloc(sizeof(struct FoodItem*));
     food->ftail = malloc(sizeof(struct FoodItem*));
 
-    struct FoodItem* f = fooditem_init(NULL, stail, xsize, ysize);
+    struct FoodItem* f = fooditem_init(NULL, stail, xsize, ysize, &food->rng);
 
     *food->fhead = f;
     *food->ftail = f;
 
     for (int i=1 ; i<maxfood ; i++)
-        fooditem_init(food->ftail, stail, xsize, ysize);
+        fooditem_init(food->ftail, stail, xsize, ysize, &food->rng);
 }
 
-struct FoodItem* fooditem_init(struct FoodItem** ftail, struct Seg* stail, uint16_t xsize, uint16_t ysize)
+struct FoodItem* fooditem_init(struct FoodItem** ftail, struct Seg* stail, uint32_t xsize, uint32_t ysize, uint32_t* rng)
 {
     struct FoodItem* f = malloc(sizeof(struct FoodItem));
+    PROF_COUNT(PROF_MALLOCS, 1);
 
-    get_free_loc(ftail, stail, xsize, ysize, &f->xpos, &f->ypos);
+    get_free_loc(ftail, stail, xsize, ysize, rng, &f->xpos, &f->ypos);
     f->next = NULL;
 
     if (ftail == NULL) {
@@ -274,7 +325,7 @@ void fooditem_destroy(struct FoodItem* f, struct FoodItem** fhead, struct FoodIt
         prev->next = NULL;
     }
     else {
-        debug("Should be unreachable\n");
+        log_error("Should be unreachable\n");
     }
     free(f);
 }
@@ -14,9 +14,6 @@
 #define SNAKE_DEBUG_FOOD_CHR 'x'
 #define SNAKE_DEBUG_SEG_CHR 'o'
 
-// position type, represents coordinate (x or y)
-typedef uint16_t Pos;
-
 // Represents direction of movement.
 // Changes after user input
 enum Direction {
@@ -48,8 +45,8 @@ struct Snake {
     // This does not necessarily reflect current length
     // After eating, the snake may need to grow (or shrink)
     // to become equal to len
-    uint16_t len;
-    uint16_t cur_len;
+    Cost len;
+    Cost cur_len;
 
     // access to snake linked list
     struct Seg** shead;
@@ -73,6 +70,9 @@ struct Food {
     struct FoodItem** fhead;
     struct FoodItem** ftail;
 
+    // random generator state for food locations
+    uint32_t rng;
+
     void(*draw_cb)(Pos x, Pos y);
 };
 
@@ -82,7 +82,7 @@ struct Game {
     uint32_t ysize;
 
     // amount of food items created
-    uint16_t score;
+    Cost score;
 
     // grow factor or the amount the snake will grow after eating it
     uint8_t grow_fac;
@@ -90,27 +90,36 @@ struct Game {
     // max amount of food items in field
     uint16_t maxfood;
 
+    // seed for random generator, same seed and moves result in same game
+    uint32_t seed;
+
     struct Snake snake;
     struct Food food;
+
+    // called with every move before it is applied, eg: for recording
+    void(*move_cb)(enum Direction v);
 };
 
 // public functions
-void game_init(struct Game* game, uint32_t xsize, uint32_t ysize, uint16_t maxfood);
+void game_init(struct Game* game, uint32_t xsize, uint32_t ysize, uint16_t maxfood, uint32_t seed);
+void game_destroy(struct Game* game);
 enum GameState game_next(struct Game* game, enum Direction v);
 void game_draw(struct Game* game);
 
 
 // private functions
+uint32_t rng_next(uint32_t* rng);
+uint32_t rng_seed(uint32_t seed);
 void snake_init(struct Snake*, Pos xstart, Pos ystart);
 void snake_lremove(struct Seg** shead, uint16_t amount);
 
 struct Seg* seg_init(struct Seg** stail, Pos xpos, Pos ypos);
 struct Seg* seg_detect_col(struct Seg* stail, Pos x, Pos y, uint16_t roffset);
 
-void food_init(struct Food* food, struct Seg* stail, uint16_t xsize, uint16_t ysize, uint16_t maxfood);
+void food_init(struct Food* food, struct Seg* stail, uint32_t xsize, uint32_t ysize, uint16_t maxfood, uint32_t seed);
 struct FoodItem* food_detect_col(struct FoodItem* ftail, Pos x, Pos y);
 
-struct FoodItem* fooditem_init(struct FoodItem** ftail, struct Seg* stail, uint16_t xsize, uint16_t ysize);
+struct FoodItem* fooditem_init(struct FoodItem** ftail, struct Seg* stail, uint32_t xsize, uint32_t ysize, uint32_t* rng);
 void fooditem_destroy(struct FoodItem* f, struct FoodItem** fhead, struct FoodItem** ftail);
 
 #endif
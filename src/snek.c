@@ -0,0 +1,213 @@
+#include "snek.h"
+#include "snake.h"
+#include "planner.h"
+
+struct Snek {
+    struct SnekConfig cfg;
+    struct Game game;
+    enum SnekResult result;
+    uint64_t nmoves;
+
+    // observation grid, xsize*ysize enum SnekCell values
+    uint8_t* obs;
+
+    // planner is allocated on first call to snek_bot_next
+    struct Planner planner;
+    bool has_planner;
+
+    // position in last planned path, path is replanned when it is used up
+    // or when a step deviates from it
+    uint32_t path_pos;
+};
+
+void snek_config_default(struct SnekConfig* cfg)
+{
+    cfg->xsize = 80;
+    cfg->ysize = 24;
+    cfg->maxfood = SNAKE_DEFAULT_MAX_FOOD;
+    cfg->grow_fac = SNAKE_DEFAULT_GROW_FACTOR;
+}
+
+static void snek_obs_build(struct Snek* snek)
+{
+    /* Build observation grid from scratch, head is written last so it
+     * wins from body on collision */
+    uint32_t xsize = snek->cfg.xsize;
+    uint8_t* cells = snek->obs;
+    memset(cells, SNEK_CELL_EMPTY, (size_t)xsize * snek->cfg.ysize);
+
+    for (struct FoodItem* f = *snek->game.food.fhead ; f != NULL ; f = f->next)
+        cells[f->ypos*xsize + f->xpos] = SNEK_CELL_FOOD;
+
+    for (struct Seg* seg = *snek->game.snake.shead ; seg != NULL ; seg = seg->next)
+        cells[seg->ypos*xsize + seg->xpos] = SNEK_CELL_BODY;
+
+    struct Seg* head = *snek->game.snake.stail;
+    cells[head->ypos*xsize + head->xpos] = SNEK_CELL_HEAD;
+}
+
+static void snek_game_init(struct Snek* snek, uint32_t seed)
+{
+    game_init(&snek->game, snek->cfg.xsize, snek->cfg.ysize, snek->cfg.maxfood, seed);
+    snek->game.grow_fac = snek->cfg.grow_fac;
+    snek->result = SNEK_RUNNING;
+    snek->nmoves = 0;
+    snek->path_pos = 0;
+    snek->planner.path.len = 0;
+    snek_obs_build(snek);
+}
+
+struct Snek* snek_create(const struct SnekConfig* cfg, uint32_t seed)
+{
+    uint64_t size = (uint64_t)cfg->xsize * cfg->ysize;
+
+    // food has to fit next to the snake, and costs up to board size must fit in Cost
+    if (cfg->xsize == 0 || cfg->ysize == 0 || cfg->maxfood == 0)
+        return NULL;
+    if (size <= (uint64_t)cfg->maxfood + 1 || size > (Cost)~0)
+        return NULL;
+
+    struct Snek* snek = malloc(sizeof(struct Snek));
+    if (snek == NULL)
+        return NULL;
+
+    snek->obs = malloc(size);
+    if (snek->obs == NULL) {
+        free(snek);
+        return NULL;
+    }
+
+    snek->cfg = *cfg;
+    snek->has_planner = false;
+    snek_game_init(snek, seed);
+    return snek;
+}
+
+void snek_destroy(struct Snek* snek)
+{
+    if (snek->has_planner)
+        planner_destroy(&snek->planner);
+    game_destroy(&snek->game);
+    free(snek->obs);
+    free(snek);
+}
+
+void snek_reset(struct Snek* snek, uint32_t seed)
+{
+    /* Start new game in same handle, planner memory is kept */
+    game_destroy(&snek->game);
+    snek_game_init(snek, seed);
+}
+
+enum SnekResult snek_step(struct Snek* snek, enum SnekDir dir)
+{
+    if (snek->result != SNEK_RUNNING || dir >= SNEK_DIR_NONE)
+        return snek->result;
+
+    // keep following planned path as long as steps agree with it
+    struct ASPath* path = &snek->planner.path;
+    if (snek->path_pos < path->len && (enum ASDir)dir == astar_path_get(path, snek->path_pos))
+        snek->path_pos++;
+    else
+        snek->path_pos = path->len;
+
+    // NOTE shead/stail refers to the head/tail of linked list, not snake's head/tail
+    struct Snake* snake = &snek->game.snake;
+    uint32_t xsize = snek->cfg.xsize;
+    uint32_t i_head = (*snake->stail)->ypos*xsize + (*snake->stail)->xpos;
+    uint32_t i_tail = (*snake->shead)->ypos*xsize + (*snake->shead)->xpos;
+    bool is_growing = snake->cur_len < snake->len;
+    Cost score = snek->game.score;
+
+    enum GameState gs = game_next(&snek->game, (enum Direction)dir);
+    snek->nmoves++;
+
+    // apply deltas to observation grid, tail can only share its cell with
+    // another segment after a collision and head is written last
+    snek->obs[i_head] = SNEK_CELL_BODY;
+    if (!is_growing)
+        snek->obs[i_tail] = SNEK_CELL_EMPTY;
+    if (snek->game.score != score) {
+        struct FoodItem* f = *snek->game.food.ftail;
+        snek->obs[f->ypos*xsize + f->xpos] = SNEK_CELL_FOOD;
+    }
+    snek->obs[(*snake->stail)->ypos*xsize + (*snake->stail)->xpos] = SNEK_CELL_HEAD;
+
+    if (gs == GAME_WON)
+        snek->result = SNEK_WON;
+    else if (gs == GAME_LOST)
+        snek->result = SNEK_LOST;
+
+    return snek->result;
+}
+
+enum SnekDir snek_bot_next(struct Snek* snek)
+{
+    /* Same moves as bot_run(), a path is planned and followed until
+     * it is used up, then the next path is planned */
+    if (snek->result != SNEK_RUNNING)
+        return SNEK_DIR_NONE;
+
+    if (!snek->has_planner) {
+        planner_init(&snek->planner, snek->cfg.xsize, snek->cfg.ysize);
+        snek->has_planner = true;
+        snek->path_pos = 0;
+        snek->planner.path.len = 0;
+    }
+
+    struct ASPath* path = &snek->planner.path;
+    if (snek->path_pos >= path->len) {
+        snek->path_pos = 0;
+        if (planner_plan(&snek->planner, &snek->game) != AS_SOLVED || path->len == 0) {
+            path->len = 0;
+            return SNEK_DIR_NONE;
+        }
+    }
+    return (enum SnekDir)astar_path_get(path, snek->path_pos);
+}
+
+enum SnekResult snek_result(const struct Snek* snek)
+{
+    return snek->result;
+}
+
+uint32_t snek_score(const struct Snek* snek)
+{
+    return snek->game.score;
+}
+
+uint32_t snek_len(const struct Snek* snek)
+{
+    return snek->game.snake.len;
+}
+
+uint64_t snek_moves(const struct Snek* snek)
+{
+    return snek->nmoves;
+}
+
+void snek_head(const struct Snek* snek, uint32_t* x, uint32_t* y)
+{
+    // NOTE stail is the snake's head
+    struct Seg* head = *snek->game.snake.stail;
+    *x = head->xpos;
+    *y = head->ypos;
+}
+
+enum SnekCell snek_cell(const struct Snek* snek, uint32_t x, uint32_t y)
+{
+    /* Get contents of one cell, out of board cells are empty */
+    if (x >= snek->cfg.xsize || y >= snek->cfg.ysize)
+        return SNEK_CELL_EMPTY;
+    return snek->obs[y*snek->cfg.xsize + x];
+}
+
+const uint8_t* snek_obs(const struct Snek* snek)
+{
+    return snek->obs;
+}
+
+void snek_observe(const struct Snek* snek, uint8_t* cells)
+{
+    memcpy(cells, snek->obs, (size_t)snek->cfg.xsize * snek->cfg.ysize);
+}
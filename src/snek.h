@@ -0,0 +1,79 @@
+#ifndef SNEK_H
+#define SNEK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* libsnek :: embeddable game core and bot
+ *
+ * Step/observe API on top of the game and planner, without curses or
+ * global state. Every game lives in its own handle so any amount of games
+ * can run side by side, one handle must only be used by one thread at a
+ * time. Build with: make lib
+ */
+
+// same order as enum Direction
+enum SnekDir {
+    SNEK_DIR_N,
+    SNEK_DIR_E,
+    SNEK_DIR_S,
+    SNEK_DIR_W,
+    SNEK_DIR_NONE
+};
+
+enum SnekCell {
+    SNEK_CELL_EMPTY,
+    SNEK_CELL_BODY,
+    SNEK_CELL_HEAD,
+    SNEK_CELL_FOOD
+};
+
+enum SnekResult {
+    SNEK_RUNNING,
+    SNEK_WON,
+    SNEK_LOST
+};
+
+struct SnekConfig {
+    uint32_t xsize;
+    uint32_t ysize;
+
+    // max amount of food items on board
+    uint16_t maxfood;
+
+    // amount the snake grows after eating
+    uint8_t grow_fac;
+};
+
+struct Snek;
+
+void snek_config_default(struct SnekConfig* cfg);
+
+// returns NULL if config is invalid or board doesn't fit in Cost type
+struct Snek* snek_create(const struct SnekConfig* cfg, uint32_t seed);
+void snek_destroy(struct Snek* snek);
+void snek_reset(struct Snek* snek, uint32_t seed);
+
+// steps after game has ended are ignored and return the final result
+enum SnekResult snek_step(struct Snek* snek, enum SnekDir dir);
+
+// next move of built in bot, SNEK_DIR_NONE if no path was found
+enum SnekDir snek_bot_next(struct Snek* snek);
+
+enum SnekResult snek_result(const struct Snek* snek);
+uint32_t snek_score(const struct Snek* snek);
+uint32_t snek_len(const struct Snek* snek);
+uint64_t snek_moves(const struct Snek* snek);
+void snek_head(const struct Snek* snek, uint32_t* x, uint32_t* y);
+
+enum SnekCell snek_cell(const struct Snek* snek, uint32_t x, uint32_t y);
+
+// board as xsize*ysize enum SnekCell values, row by row. Grid is owned by
+// game and updated incrementally with every step, pointer stays valid
+// until snek_destroy()
+const uint8_t* snek_obs(const struct Snek* snek);
+
+// copy of snek_obs() grid
+void snek_observe(const struct Snek* snek, uint8_t* cells);
+
+#endif
@@ -3,7 +3,14 @@
 
 enum GameMode {
     GM_BOT,
-    GM_USER
+    GM_USER,
+    GM_REPLAY,
+    GM_CORPUS,
+    GM_BENCH,
+    GM_METRICS,
+    GM_TOURNEY,
+    GM_TUNE,
+    GM_TRACE
 };
 
 struct State {
@@ -11,14 +18,63 @@ struct State {
     bool is_stopped;
     bool is_paused;
 
-    Pos xsize;
-    Pos ysize;
+    // board size, 0 is size of terminal
+    uint32_t xsize;
+    uint32_t ysize;
 
     enum GameMode mode;
     uint32_t speed_ms;
 
+    // draw every n game ticks and no more than fps frames per second
+    uint32_t frame_skip;
+    uint32_t fps;
+
     uint8_t grow_amount;
-    uint8_t max_food;
+    uint16_t max_food;
+
+    int log_level;
+
+    uint32_t seed;
+
+    // record game to file, or replay game from file
+    char* record_path;
+    char* replay_path;
+
+    // planner benchmark corpus file, amount of games and sample interval
+    char* corpus_path;
+    uint32_t ngames;
+    uint32_t interval;
+
+    // publish live bot metrics to file, or read them in GM_METRICS mode
+    char* metrics_path;
+
+    // checkpoint bot game to file every checkpoint_ms, or resume from file
+    char* checkpoint_path;
+    char* resume_path;
+    uint32_t checkpoint_ms;
+
+    // record bot searches to file, or view them in GM_TRACE mode
+    char* trace_path;
+
+    // don't draw anything
+    bool is_headless;
+
+    // name of bot strategy, see bot_strategy_find()
+    char* strategy;
+
+    // snake length from which tail is chased, 0 is strategy default.
+    // Set from tuned parameter table for default strategy
+    uint32_t longest_len;
+
+    // tuned parameter table to load, or to write in GM_TUNE mode
+    char* tune_path;
+
+    // strategy tournament seeds and worker threads, 0 is one per cpu
+    uint32_t nseeds;
+    uint32_t nthreads;
+
+    // bot rejects moves into cut cells that lead into the smaller region
+    bool use_artic;
 };
 
 #endif
@@ -0,0 +1,195 @@
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "tourney.h"
+#include "log.h"
+
+struct Tourney {
+    struct State* state;
+    uint32_t xsize;
+    uint32_t ysize;
+
+    struct TourneyGame* games;
+    uint32_t ngames;
+
+    // index of next game to play, shared by workers
+    _Atomic uint32_t next;
+};
+
+static uint64_t tourney_cpu_ns()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+    return (uint64_t)t.tv_sec*1000000000 + t.tv_nsec;
+}
+
+static void tourney_play_game(struct Tourney* t, struct TourneyGame* tg)
+{
+    /* Play one headless game, on its own state so the shared one isn't
+     * changed. Game stops when the shared state is stopped */
+    struct State s = *t->state;
+    s.speed_ms = 0;
+    s.longest_len = 0;
+
+    struct Game game;
+    game_init(&game, t->xsize, t->ysize, s.max_food, tg->seed);
+    game.grow_fac = s.grow_amount;
+
+    struct Bot bot;
+    bot_init_strategy(&bot, &game, &s, tg->strategy, t->xsize, t->ysize);
+    bot.is_stopped = &t->state->is_stopped;
+    bot.max_idle_moves = (uint64_t)TOURNEY_IDLE_FAC * t->xsize * t->ysize;
+
+    uint64_t t_start = tourney_cpu_ns();
+    tg->res = bot_run(&bot);
+    tg->cpu_ns = tourney_cpu_ns() - t_start;
+    tg->score = game.score;
+    tg->nmoves = bot.nmoves;
+
+    // game that was cut short by a stop doesn't count
+    tg->is_played = !t->state->is_stopped;
+
+    log_info("tourney: %s seed=%u result=%d score=%u moves=%lu\n",
+             tg->strategy->name, tg->seed, tg->res, tg->score, (unsigned long)tg->nmoves);
+
+    bot_destroy(&bot);
+    game_destroy(&game);
+}
+
+static void* tourney_worker(void* arg)
+{
+    /* Play games until all are taken, or tournament is stopped */
+    struct Tourney* t = arg;
+
+    while (!t->state->is_stopped) {
+        uint32_t i = atomic_fetch_add(&t->next, 1);
+        if (i >= t->ngames)
+            break;
+        tourney_play_game(t, &t->games[i]);
+    }
+    return NULL;
+}
+
+static int cmp_score(const void* a, const void* b)
+{
+    uint32_t sa = *(const uint32_t*)a;
+    uint32_t sb = *(const uint32_t*)b;
+    return (sa > sb) - (sa < sb);
+}
+
+static void tourney_result(struct TourneyGame* games, uint32_t nseeds, uint32_t* scores, struct TourneyResult* r)
+{
+    /* Summarize games of one strategy */
+    memset(r, 0, sizeof(*r));
+
+    for (uint32_t i=0 ; i<nseeds ; i++) {
+        // tournament was stopped early
+        if (!games[i].is_played)
+            continue;
+
+        scores[r->ngames++] = games[i].score;
+        r->sum_score += games[i].score;
+        r->nmoves += games[i].nmoves;
+        r->cpu_ns += games[i].cpu_ns;
+        if (games[i].res == BOT_WON)
+            r->nwon++;
+    }
+
+    if (r->ngames == 0)
+        return;
+
+    qsort(scores, r->ngames, sizeof(uint32_t), &cmp_score);
+    r->mean = (double)r->sum_score / r->ngames;
+    r->median = (r->ngames % 2) ? scores[r->ngames/2] : (scores[r->ngames/2-1] + scores[r->ngames/2]) / 2.0;
+}
+
+bool tourney_play(struct State* state, const struct BotStrategy* strategies, uint32_t nstrategies,
+                  uint32_t xsize, uint32_t ysize, uint32_t nseeds, uint32_t nthreads, struct TourneyResult* results)
+{
+    /* Play strategies on seeds state->seed..seed+nseeds, results has one
+     * entry per strategy */
+    struct Tourney t;
+    t.state = state;
+    t.xsize = xsize;
+    t.ysize = ysize;
+    t.ngames = nstrategies * nseeds;
+    t.games = calloc(t.ngames, sizeof(struct TourneyGame));
+    atomic_init(&t.next, 0);
+
+    if (t.games == NULL)
+        return false;
+
+    for (uint32_t si=0 ; si<nstrategies ; si++) {
+        for (uint32_t i=0 ; i<nseeds ; i++) {
+            struct TourneyGame* tg = &t.games[si*nseeds + i];
+            tg->strategy = &strategies[si];
+            tg->seed = state->seed + i;
+            tg->is_played = false;
+        }
+    }
+
+    if (nthreads == 0)
+        nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (nthreads > t.ngames)
+        nthreads = t.ngames;
+
+    pthread_t* threads = malloc(nthreads * sizeof(pthread_t));
+    uint32_t nstarted = 0;
+    for ( ; nstarted<nthreads ; nstarted++) {
+        if (pthread_create(&threads[nstarted], NULL, tourney_worker, &t) != 0)
+            break;
+    }
+
+    // play on this thread when no worker could be started
+    if (nstarted == 0)
+        tourney_worker(&t);
+
+    for (uint32_t i=0 ; i<nstarted ; i++)
+        pthread_join(threads[i], NULL);
+
+    uint32_t* scores = malloc(nseeds * sizeof(uint32_t));
+    for (uint32_t si=0 ; si<nstrategies ; si++)
+        tourney_result(&t.games[si*nseeds], nseeds, scores, &results[si]);
+
+    free(scores);
+    free(threads);
+    free(t.games);
+    return true;
+}
+
+bool tourney_run(struct State* state, uint32_t xsize, uint32_t ysize, uint32_t nseeds, uint32_t nthreads, FILE* out)
+{
+    /* Play all registered strategies and print one row per strategy */
+    uint32_t n = bot_strategy_count();
+    struct TourneyResult* results = malloc(n * sizeof(struct TourneyResult));
+
+    fprintf(out, "tourney: %u strategies, %u seeds from %u on %ux%u board\n",
+            n, nseeds, state->seed, xsize, ysize);
+
+    // registered strategies are stored consecutively
+    if (!tourney_play(state, bot_strategy_get(0), n, xsize, ysize, nseeds, nthreads, results)) {
+        free(results);
+        return false;
+    }
+
+    fprintf(out, "%-12s %6s %10s %8s %6s %10s %12s\n",
+            "strategy", "games", "mean", "median", "win%", "moves/food", "cpu_ms/move");
+
+    for (uint32_t si=0 ; si<n ; si++) {
+        struct TourneyResult* r = &results[si];
+        if (r->ngames == 0)
+            continue;
+
+        fprintf(out, "%-12s %6u %10.1f %8.1f %6.1f %10.1f %12.4f\n",
+                bot_strategy_get(si)->name, r->ngames, r->mean, r->median,
+                100.0 * r->nwon / r->ngames,
+                (r->sum_score > 0) ? (double)r->nmoves / r->sum_score : 0.0,
+                (r->nmoves > 0) ? r->cpu_ns / 1e6 / r->nmoves : 0.0);
+    }
+
+    free(results);
+    return true;
+}
@@ -0,0 +1,51 @@
+#ifndef TOURNEY_H
+#define TOURNEY_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "bot.h"
+#include "state.h"
+
+/* Strategy tournament
+ *
+ * Every registered bot strategy plays headless games on the same seeds,
+ * games are spread over worker threads. Games that stop scoring, eg: a
+ * snake that chases its tail forever, are stopped after
+ * TOURNEY_IDLE_FAC moves per board cell without food.
+ */
+
+#define TOURNEY_DEFAULT_XSIZE 40
+#define TOURNEY_DEFAULT_YSIZE 20
+#define TOURNEY_DEFAULT_SEEDS 16
+#define TOURNEY_IDLE_FAC 4
+
+struct TourneyGame {
+    const struct BotStrategy* strategy;
+    uint32_t seed;
+
+    bool is_played;
+    enum BotResult res;
+    uint32_t score;
+    uint64_t nmoves;
+    uint64_t cpu_ns;
+};
+
+// results of all games of one strategy
+struct TourneyResult {
+    uint32_t ngames;
+    uint32_t nwon;
+    double mean;
+    double median;
+    uint64_t sum_score;
+    uint64_t nmoves;
+    uint64_t cpu_ns;
+};
+
+bool tourney_play(struct State* state, const struct BotStrategy* strategies, uint32_t nstrategies,
+                  uint32_t xsize, uint32_t ysize, uint32_t nseeds, uint32_t nthreads, struct TourneyResult* results);
+bool tourney_run(struct State* state, uint32_t xsize, uint32_t ysize, uint32_t nseeds, uint32_t nthreads, FILE* out);
+
+#endif
@@ -0,0 +1,187 @@
+#include <string.h>
+#include <time.h>
+
+#include "trace.h"
+
+static uint64_t trace_now_ns()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec*1000000000 + t.tv_nsec;
+}
+
+static void* trace_thread(void* arg)
+{
+    /* Write buffers as they are handed over, until stopped and nothing is
+     * left to write */
+    struct Trace* t = arg;
+
+    pthread_mutex_lock(&t->lock);
+    while (1) {
+        while (!t->is_pending && t->is_running)
+            pthread_cond_wait(&t->cond, &t->lock);
+
+        if (!t->is_pending)
+            break;
+
+        pthread_mutex_unlock(&t->lock);
+        bool is_written = fwrite(t->wbuf, sizeof(struct TraceEvent), t->wlen, t->fp) == t->wlen;
+        pthread_mutex_lock(&t->lock);
+
+        if (!is_written)
+            t->is_failed = true;
+
+        t->is_pending = false;
+        pthread_cond_broadcast(&t->cond);
+    }
+    pthread_mutex_unlock(&t->lock);
+    return NULL;
+}
+
+bool trace_open(struct Trace* t, const char* path, uint32_t xsize, uint32_t ysize)
+{
+    /* Create trace file and start writer thread */
+    t->fp = fopen(path, "wb");
+    if (t->fp == NULL)
+        return false;
+
+    struct TraceHeader hdr;
+    memcpy(hdr.magic, TRACE_MAGIC, sizeof(hdr.magic));
+    hdr.version = TRACE_VERSION;
+    hdr.xsize = xsize;
+    hdr.ysize = ysize;
+
+    t->xsize = xsize;
+    t->ysize = ysize;
+    t->buf = malloc(TRACE_BUFSIZE * sizeof(struct TraceEvent));
+    t->wbuf = malloc(TRACE_BUFSIZE * sizeof(struct TraceEvent));
+    t->len = 0;
+    t->wlen = 0;
+    t->is_pending = false;
+    t->is_failed = false;
+
+    t->nevents = 0;
+    t->nflushes = 0;
+    t->nstalls = 0;
+    t->stall_ns_max = 0;
+
+    pthread_mutex_init(&t->lock, NULL);
+    pthread_cond_init(&t->cond, NULL);
+
+    t->is_running = true;
+
+    if (t->buf == NULL || t->wbuf == NULL || fwrite(&hdr, sizeof(hdr), 1, t->fp) != 1 ||
+        pthread_create(&t->thread, NULL, trace_thread, t) != 0) {
+        t->is_running = false;
+        trace_close(t);
+        return false;
+    }
+    return true;
+}
+
+void trace_flush(struct Trace* t)
+{
+    /* Hand buffered events to writer, waits if writer is still busy with
+     * the previous buffer so no events are lost */
+    if (t->len == 0)
+        return;
+
+    pthread_mutex_lock(&t->lock);
+    if (t->is_pending) {
+        uint64_t t_start = trace_now_ns();
+        while (t->is_pending)
+            pthread_cond_wait(&t->cond, &t->lock);
+
+        uint64_t dt = trace_now_ns() - t_start;
+        if (dt > t->stall_ns_max)
+            t->stall_ns_max = dt;
+        t->nstalls++;
+    }
+
+    struct TraceEvent* tmp = t->wbuf;
+    t->wbuf = t->buf;
+    t->wlen = t->len;
+    t->buf = tmp;
+    t->is_pending = true;
+    pthread_cond_broadcast(&t->cond);
+    pthread_mutex_unlock(&t->lock);
+
+    t->nevents += t->len;
+    t->nflushes++;
+    t->len = 0;
+}
+
+bool trace_close(struct Trace* t)
+{
+    /* Write remaining events, stop writer and close file, false if
+     * anything failed to write */
+    if (t->is_running) {
+        trace_flush(t);
+
+        pthread_mutex_lock(&t->lock);
+        t->is_running = false;
+        pthread_cond_broadcast(&t->cond);
+        pthread_mutex_unlock(&t->lock);
+
+        pthread_join(t->thread, NULL);
+    }
+    else {
+        t->is_failed = true;
+    }
+
+    if (fclose(t->fp) != 0)
+        t->is_failed = true;
+
+    pthread_mutex_destroy(&t->lock);
+    pthread_cond_destroy(&t->cond);
+    free(t->buf);
+    free(t->wbuf);
+    return !t->is_failed;
+}
+
+bool trace_reader_open(struct TraceReader* r, const char* path)
+{
+    /* Open trace for reading, false when file isn't a trace of a valid
+     * board */
+    r->fp = fopen(path, "rb");
+    if (r->fp == NULL)
+        return false;
+
+    // cells are row major indices, board has to fit them
+    if (fread(&r->header, sizeof(r->header), 1, r->fp) != 1 ||
+        memcmp(r->header.magic, TRACE_MAGIC, sizeof(r->header.magic)) != 0 ||
+        r->header.version != TRACE_VERSION || r->header.xsize == 0 || r->header.ysize == 0 ||
+        (uint64_t)r->header.xsize*r->header.ysize > UINT32_MAX) {
+        fclose(r->fp);
+        return false;
+    }
+
+    r->buf = malloc(TRACE_BUFSIZE * sizeof(struct TraceEvent));
+    if (r->buf == NULL) {
+        fclose(r->fp);
+        return false;
+    }
+
+    r->len = 0;
+    r->pos = 0;
+    return true;
+}
+
+void trace_reader_close(struct TraceReader* r)
+{
+    fclose(r->fp);
+    free(r->buf);
+}
+
+bool trace_read(struct TraceReader* r, struct TraceEvent* ev)
+{
+    /* Read next event, false at end of trace */
+    if (r->pos == r->len) {
+        r->len = fread(r->buf, sizeof(struct TraceEvent), TRACE_BUFSIZE, r->fp);
+        r->pos = 0;
+        if (r->len == 0)
+            return false;
+    }
+    *ev = r->buf[r->pos++];
+    return true;
+}
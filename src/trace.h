@@ -0,0 +1,111 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+/* Traces of A* searches for offline debugging
+ *
+ * File layout, all fields in host byte order:
+ *   header:  magic, version and board size
+ *   events:  struct TraceEvent until end of file
+ *
+ * Every search starts with a TRACE_PLAN event, followed by its goals and
+ * walls, the nodes it opened and closed in order, the path when solved
+ * and a TRACE_DONE event. Cells are row major indices, y*xsize + x.
+ *
+ * Events are appended to a buffer in memory. Full buffers are swapped
+ * with a background thread that writes them, the search only waits when
+ * the writer hasn't finished the previous buffer yet.
+ */
+
+#define TRACE_MAGIC "SNKT"
+#define TRACE_VERSION 1
+
+// events per buffer, two buffers are in memory while tracing
+#define TRACE_BUFSIZE 65536
+
+enum TraceType {
+    TRACE_PLAN,     // cell: start, g: enum ASPathType
+    TRACE_GOAL,     // cell: goal
+    TRACE_WALL,     // cell: wall
+    TRACE_OPEN,     // cell: node added to openset or updated, g and f of node
+    TRACE_CLOSE,    // cell: node expanded, g and f of node
+    TRACE_PATH,     // cell: node on solved path, g: step
+    TRACE_DONE      // g: enum ASResult
+};
+
+struct __attribute__((packed)) TraceHeader {
+    char magic[4];
+    uint8_t version;
+    uint32_t xsize;
+    uint32_t ysize;
+};
+
+struct __attribute__((packed)) TraceEvent {
+    uint8_t type;
+    uint32_t cell;
+    uint32_t g;
+    uint32_t f;
+};
+
+struct Trace {
+    FILE* fp;
+    uint32_t xsize;
+    uint32_t ysize;
+
+    // buffer that events are appended to
+    struct TraceEvent* buf;
+    uint32_t len;
+
+    // buffer that is written, owned by writer while is_pending is set
+    struct TraceEvent* wbuf;
+    uint32_t wlen;
+    bool is_pending;
+
+    bool is_running;
+    bool is_failed;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+
+    // stats, stalls are flushes that waited for the writer
+    uint64_t nevents;
+    uint64_t nflushes;
+    uint64_t nstalls;
+    uint64_t stall_ns_max;
+};
+
+struct TraceReader {
+    FILE* fp;
+    struct TraceHeader header;
+
+    struct TraceEvent* buf;
+    uint32_t len;
+    uint32_t pos;
+};
+
+bool trace_open(struct Trace* t, const char* path, uint32_t xsize, uint32_t ysize);
+bool trace_close(struct Trace* t);
+void trace_flush(struct Trace* t);
+
+static inline void trace_add(struct Trace* t, enum TraceType type, uint32_t cell, uint32_t g, uint32_t f)
+{
+    if (t->len == TRACE_BUFSIZE)
+        trace_flush(t);
+
+    struct TraceEvent* ev = &t->buf[t->len++];
+    ev->type = type;
+    ev->cell = cell;
+    ev->g = g;
+    ev->f = f;
+}
+
+bool trace_reader_open(struct TraceReader* r, const char* path);
+void trace_reader_close(struct TraceReader* r);
+bool trace_read(struct TraceReader* r, struct TraceEvent* ev);
+
+#endif
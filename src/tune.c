@@ -0,0 +1,181 @@
+#include <string.h>
+#include <math.h>
+
+#include "tune.h"
+#include "tourney.h"
+#include "bot.h"
+
+// boards that are tuned when no board size is given
+static const uint32_t tune_boards[][2] = {
+    {20, 12},
+    {40, 20},
+    {80, 24},
+};
+
+static const uint32_t tune_lens[] = {10, 25, 50, 100, 200, 400, 800};
+
+#define TUNE_NLENS (sizeof(tune_lens)/sizeof(tune_lens[0]))
+#define TUNE_NAME_SIZE 32
+
+static bool tune_board(struct State* state, uint32_t xsize, uint32_t ysize, uint32_t nseeds, uint32_t nthreads,
+                       struct TuneEntry* entry, FILE* out)
+{
+    /* Sweep variants of default strategy on one board and pick best */
+    const struct BotStrategy* base = bot_strategy_find(BOT_DEFAULT_STRATEGY);
+    struct BotStrategy variants[TUNE_NLENS*2];
+    char names[TUNE_NLENS*2][TUNE_NAME_SIZE];
+    struct TourneyResult results[TUNE_NLENS*2];
+    uint32_t n = 0;
+
+    // thresholds beyond board size all behave the same
+    for (uint32_t li=0 ; li<TUNE_NLENS && tune_lens[li] < xsize*ysize ; li++) {
+        for (int artic=0 ; artic<2 ; artic++) {
+            variants[n] = *base;
+            variants[n].longest_len = tune_lens[li];
+            variants[n].use_artic = artic;
+            snprintf(names[n], TUNE_NAME_SIZE, "len=%u%s", tune_lens[li], artic ? "+artic" : "");
+            variants[n].name = names[n];
+            n++;
+        }
+    }
+
+    if (!tourney_play(state, variants, n, xsize, ysize, nseeds, nthreads, results))
+        return false;
+
+    double best_mean = 0;
+    for (uint32_t i=0 ; i<n ; i++) {
+        if (results[i].mean > best_mean)
+            best_mean = results[i].mean;
+    }
+
+    int32_t best = -1;
+    double best_rate = 0;
+    for (uint32_t i=0 ; i<n ; i++) {
+        struct TourneyResult* r = &results[i];
+        double rate = (r->cpu_ns > 0) ? r->sum_score / (r->cpu_ns / 1e9) : 0.0;
+        if (r->ngames > 0 && r->mean >= TUNE_MIN_SCORE_FRAC*best_mean && (best < 0 || rate > best_rate)) {
+            best = i;
+            best_rate = rate;
+        }
+    }
+
+    fprintf(out, "board %ux%u\n", xsize, ysize);
+    fprintf(out, "  %-16s %10s %14s %14s\n", "variant", "mean", "cpu_ms/game", "score/cpu_s");
+    for (uint32_t i=0 ; i<n ; i++) {
+        struct TourneyResult* r = &results[i];
+        uint32_t ngames = (r->ngames > 0) ? r->ngames : 1;
+        fprintf(out, "%s %-16s %10.1f %14.2f %14.1f\n",
+                ((int32_t)i == best) ? "*" : " ", variants[i].name, r->mean, r->cpu_ns / 1e6 / ngames,
+                (r->cpu_ns > 0) ? r->sum_score / (r->cpu_ns / 1e9) : 0.0);
+    }
+
+    if (best < 0)
+        return false;
+
+    entry->xsize = xsize;
+    entry->ysize = ysize;
+    entry->longest_len = variants[best].longest_len;
+    entry->use_artic = variants[best].use_artic;
+    entry->mean_score = results[best].mean;
+    entry->cpu_ms = results[best].cpu_ns / 1e6 / results[best].ngames;
+    return true;
+}
+
+bool tune_run(struct State* state, const char* path, uint32_t nseeds, uint32_t nthreads, FILE* out)
+{
+    /* Tune given board size, or all default boards, and write table */
+    uint32_t boards[sizeof(tune_boards)/sizeof(tune_boards[0])][2];
+    uint32_t nboards = 0;
+
+    if (state->xsize > 0 && state->ysize > 0) {
+        boards[0][0] = state->xsize;
+        boards[0][1] = state->ysize;
+        nboards = 1;
+    }
+    else {
+        memcpy(boards, tune_boards, sizeof(tune_boards));
+        nboards = sizeof(tune_boards)/sizeof(tune_boards[0]);
+    }
+
+    struct TuneEntry entries[sizeof(tune_boards)/sizeof(tune_boards[0])];
+    uint32_t n = 0;
+
+    fprintf(out, "tune: %u boards, %u seeds from %u\n", nboards, nseeds, state->seed);
+
+    for (uint32_t bi=0 ; bi<nboards && !state->is_stopped ; bi++) {
+        if (tune_board(state, boards[bi][0], boards[bi][1], nseeds, nthreads, &entries[n], out))
+            n++;
+    }
+
+    if (state->is_stopped || n == 0)
+        return false;
+
+    FILE* fp = fopen(path, "w");
+    if (fp == NULL)
+        return false;
+
+    fprintf(fp, "# csnek tuned parameters, %u seeds from %u\n", nseeds, state->seed);
+    fprintf(fp, "# xsize ysize longest_len use_artic mean_score cpu_ms_per_game\n");
+    for (uint32_t i=0 ; i<n ; i++) {
+        struct TuneEntry* e = &entries[i];
+        fprintf(fp, "%u %u %u %d %.1f %.2f\n", e->xsize, e->ysize, e->longest_len, e->use_artic, e->mean_score, e->cpu_ms);
+    }
+
+    fprintf(out, "tune: wrote %u boards to %s\n", n, path);
+    return fclose(fp) == 0;
+}
+
+bool tune_load(struct TuneTable* table, const char* path)
+{
+    /* Read table, lines that don't parse are skipped */
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL)
+        return false;
+
+    table->entries = NULL;
+    table->n = 0;
+
+    char line[256];
+    uint32_t size = 0;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        struct TuneEntry e;
+        int use_artic;
+
+        if (line[0] == '#')
+            continue;
+        if (sscanf(line, "%u %u %u %d %lf %lf", &e.xsize, &e.ysize, &e.longest_len, &use_artic, &e.mean_score, &e.cpu_ms) != 6)
+            continue;
+        e.use_artic = use_artic;
+
+        if (table->n == size) {
+            size = (size > 0) ? size*2 : 8;
+            table->entries = realloc(table->entries, size * sizeof(struct TuneEntry));
+        }
+        table->entries[table->n++] = e;
+    }
+
+    fclose(fp);
+    return table->n > 0;
+}
+
+void tune_destroy(struct TuneTable* table)
+{
+    free(table->entries);
+}
+
+const struct TuneEntry* tune_find(struct TuneTable* table, uint32_t xsize, uint32_t ysize)
+{
+    /* Entry of board with nearest amount of cells, by ratio */
+    const struct TuneEntry* best = NULL;
+    double best_d = 0;
+
+    for (uint32_t i=0 ; i<table->n ; i++) {
+        struct TuneEntry* e = &table->entries[i];
+        double d = fabs(log((double)e->xsize*e->ysize / ((double)xsize*ysize)));
+        if (best == NULL || d < best_d) {
+            best = e;
+            best_d = d;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,52 @@
+#ifndef TUNE_H
+#define TUNE_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "snake.h"
+#include "state.h"
+
+/* Offline tuning of bot parameters per board size
+ *
+ * Variants of the default strategy are played on the same seeds for every
+ * board size, see tourney_play(), sweeping the length from which the tail
+ * is chased and cut cell rejection. Per board the variant with the best
+ * score per cpu second is chosen from the variants that score at least
+ * TUNE_MIN_SCORE_FRAC of the best mean score, so quick early deaths don't
+ * win.
+ *
+ * Table is a text file with one board per line, '#' starts a comment:
+ *   xsize ysize longest_len use_artic mean_score cpu_ms_per_game
+ *
+ * The bot loads the table given with -O and uses the entry of the board
+ * with the nearest amount of cells.
+ */
+
+#define TUNE_MIN_SCORE_FRAC 0.9
+
+struct TuneEntry {
+    uint32_t xsize;
+    uint32_t ysize;
+    uint32_t longest_len;
+    bool use_artic;
+
+    // result of chosen variant
+    double mean_score;
+    double cpu_ms;
+};
+
+struct TuneTable {
+    struct TuneEntry* entries;
+    uint32_t n;
+};
+
+bool tune_run(struct State* state, const char* path, uint32_t nseeds, uint32_t nthreads, FILE* out);
+
+bool tune_load(struct TuneTable* table, const char* path);
+void tune_destroy(struct TuneTable* table);
+const struct TuneEntry* tune_find(struct TuneTable* table, uint32_t xsize, uint32_t ysize);
+
+#endif
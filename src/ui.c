@@ -2,6 +2,10 @@
 
 WINDOW *ui_window = NULL;
 
+// cached glyph and color pair per cell style, see ui_style_add()
+cchar_t ui_styles[UI_STYLE_MAX];
+uint8_t ui_nstyles = 0;
+
 int ui_init()
 {
     // https://stackoverflow.com/questions/61347351/ncurses-stdin-redirection
@@ -150,3 +154,95 @@ void ui_show_error(WINDOW* win, char* fmt, ...)
 
     va_end(ptr);
 }
+
+int ui_style_add(char* glyph, int32_t fgcol, int32_t bgcol)
+{
+    /* Cache a glyph with its color pair so cells don't have to recompute
+     * attributes on every draw. Returns style index or -1 on error */
+    if (ui_nstyles == 0) {
+        // style 0 is an empty cell in the default window colors
+        setcchar(&ui_styles[0], L" ", A_NORMAL, 0, NULL);
+        ui_nstyles++;
+    }
+
+    if (ui_nstyles >= UI_STYLE_MAX)
+        return -1;
+
+    // fall back to ascii when glyph can't be converted in current locale
+    wchar_t wc[2] = {L'\0'};
+    if (mbstowcs(wc, glyph, 1) == (size_t)-1)
+        wc[0] = L'#';
+
+    setcchar(&ui_styles[ui_nstyles], wc, A_NORMAL, fgcol + ((bgcol-1)*ncolors), NULL);
+    return ui_nstyles++;
+}
+
+void ui_frame_init(struct UIFrame* frame, uint32_t xsize, uint32_t ysize)
+{
+    frame->xsize = xsize;
+    frame->ysize = ysize;
+    frame->xoff = 0;
+    frame->yoff = 0;
+    frame->cells = calloc(xsize*ysize, sizeof(uint8_t));
+}
+
+void ui_frame_destroy(struct UIFrame* frame)
+{
+    free(frame->cells);
+    frame->cells = NULL;
+}
+
+void ui_frame_clear(struct UIFrame* frame)
+{
+    memset(frame->cells, 0, frame->xsize*frame->ysize);
+}
+
+void ui_frame_set(struct UIFrame* frame, uint32_t x, uint32_t y, uint8_t style)
+{
+    /* Set cell at board coordinates, cells outside of frame are clipped.
+     * Coordinates left or above offset wrap around and are clipped as well */
+    x -= frame->xoff;
+    y -= frame->yoff;
+
+    if (x < frame->xsize && y < frame->ysize)
+        frame->cells[y*frame->xsize + x] = style;
+}
+
+static uint32_t center_offset(uint32_t pos, uint32_t frame_size, uint32_t board_size)
+{
+    if (board_size <= frame_size || pos < frame_size/2)
+        return 0;
+    if (pos - frame_size/2 > board_size - frame_size)
+        return board_size - frame_size;
+    return pos - frame_size/2;
+}
+
+void ui_frame_center(struct UIFrame* frame, uint32_t x, uint32_t y, uint32_t board_xsize, uint32_t board_ysize)
+{
+    /* Scroll viewport over a board that is bigger than frame so x,y is
+     * in the center, but never past the edges of the board */
+    frame->xoff = center_offset(x, frame->xsize, board_xsize);
+    frame->yoff = center_offset(y, frame->ysize, board_ysize);
+}
+
+void ui_frame_draw(WINDOW* win, struct UIFrame* frame)
+{
+    /* Flush frame to window, every row is build from cached styles
+     * and written with one call. Frame is clipped to window size */
+    uint32_t xmax, ymax;
+    getmaxyx(win, ymax, xmax);
+
+    uint32_t xsize = (frame->xsize < xmax) ? frame->xsize : xmax;
+    uint32_t ysize = (frame->ysize < ymax) ? frame->ysize : ymax;
+
+    cchar_t row[xsize];
+
+    for (uint32_t y=0 ; y<ysize ; y++) {
+        uint8_t* cell = &frame->cells[y*frame->xsize];
+
+        for (uint32_t x=0 ; x<xsize ; x++, cell++)
+            row[x] = ui_styles[*cell];
+
+        mvwadd_wchnstr(win, y, 0, row, xsize);
+    }
+}
@@ -23,6 +23,22 @@
 
 #define MSGSIZ 64
 
+// max amount of cached cell styles, style 0 is an empty cell
+#define UI_STYLE_MAX 16
+
+// Offscreen cell buffer, cells are set by index of a cached style and
+// flushed to a window with one call per row
+struct UIFrame {
+    uint32_t xsize;
+    uint32_t ysize;
+
+    // board coordinates of top left cell, when board is bigger than frame
+    uint32_t xoff;
+    uint32_t yoff;
+
+    uint8_t* cells;
+};
+
 static const int8_t ccolors[] = {-1, COLOR_RED, COLOR_GREEN, COLOR_YELLOW, COLOR_BLUE, COLOR_MAGENTA, COLOR_CYAN, COLOR_WHITE, COLOR_BLACK}; 
 static const uint8_t ncolors = 9;
 
@@ -43,4 +59,13 @@ int add_str_center(WINDOW* win, int32_t fgcol, int32_t bgcol, char* fmt, ...);
 
 void ui_show_error(WINDOW* win, char* fmt, ...);
 
+int ui_style_add(char* glyph, int32_t fgcol, int32_t bgcol);
+
+void ui_frame_init(struct UIFrame* frame, uint32_t xsize, uint32_t ysize);
+void ui_frame_destroy(struct UIFrame* frame);
+void ui_frame_clear(struct UIFrame* frame);
+void ui_frame_set(struct UIFrame* frame, uint32_t x, uint32_t y, uint8_t style);
+void ui_frame_center(struct UIFrame* frame, uint32_t x, uint32_t y, uint32_t board_xsize, uint32_t board_ysize);
+void ui_frame_draw(WINDOW* win, struct UIFrame* frame);
+
 #endif
@@ -10,13 +10,23 @@
 #include <math.h>
 #include <time.h>
 #include <sys/time.h>   // for non blocking sleep
-#include <curses.h>
 #include <errno.h>
 
+#include "log.h"
 
 #define LOG_PATH "./snake.log"
 
-void debug(char* fmt, ...);
+// Board coordinates and costs (path costs, path and snake lengths).
+// 16 bit types limit boards to 65535 cells, build with: make WIDE=1
+// for 32 bit types on huge boards
+#ifdef SNEK_WIDE
+typedef uint32_t Pos;
+typedef uint32_t Cost;
+#else
+typedef uint16_t Pos;
+typedef uint16_t Cost;
+#endif
+
 void die(char* msg);
 
 #endif